@@ -0,0 +1,135 @@
+#define _GNU_SOURCE
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "binomial.h"
+#include "monte_carlo.h"
+
+// Losowanie przegródki dla kulki z prog18: pierwotne throwBall (10 x rand_r),
+// popcount jednego słowa xoshiro256** i wsadowe binomial_fill (4 kulki na
+// słowo, generator AVX2). Podaje kulki/s w jednym wątku, potem test chi-kwadrat
+// względem rozkładu dwumianowego dla kilku liczb rzutów; kod wyjścia 1, jeśli
+// któraś szybka ścieżka go nie przechodzi.
+// Użycie: ./bench_binomial [kulki w milionach]
+
+#define DEFAULT_MBALLS 20
+#define FLIPS 10          // BIN_COUNT - 1 w prog18
+#define BATCH 4096
+#define ALPHA 0.001       // test odrzuca przy p < ALPHA
+#define TEST_BALLS 10000000
+
+typedef void (*sampler)(mc_rng *rng, unsigned flips, uint64_t balls, uint64_t *counts);
+
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// throwBall z prog18; ziarno rand_r z pierwszego słowa stanu
+static void rand_sampler(mc_rng *rng, unsigned flips, uint64_t balls, uint64_t *counts)
+{
+    unsigned int seed = (unsigned int)rng->s[0][0];
+    for(uint64_t b = 0; b < balls; b++)
+    {
+        int result = 0;
+        for(unsigned i = 0; i < flips; i++)
+            if((double)rand_r(&seed) / (double)RAND_MAX > 0.5)
+                result++;
+        counts[result]++;
+    }
+}
+
+static void popcount_sampler(mc_rng *rng, unsigned flips, uint64_t balls, uint64_t *counts)
+{
+    for(uint64_t b = 0; b < balls; b++)
+        counts[binomial_sample(rng, flips)]++;
+}
+
+static void batch_sampler(mc_rng *rng, unsigned flips, uint64_t balls, uint64_t *counts)
+{
+    uint8_t bins[BATCH];
+    while(balls > 0)
+    {
+        size_t n = balls < BATCH ? balls : BATCH;
+        binomial_fill(rng, flips, bins, n);
+        for(size_t i = 0; i < n; i++)
+            counts[bins[i]]++;
+        balls -= n;
+    }
+}
+
+// Celowo zła próbka: o jeden rzut za dużo, obcięta do `flips` - test musi ją odrzucić
+static void biased_sampler(mc_rng *rng, unsigned flips, uint64_t balls, uint64_t *counts)
+{
+    for(uint64_t b = 0; b < balls; b++)
+    {
+        unsigned k = binomial_sample(rng, flips + 1);
+        counts[k > flips ? flips : k]++;
+    }
+}
+
+static double measure(const char *name, sampler fn, uint64_t balls, double baseline)
+{
+    uint64_t counts[BINOMIAL_MAX_FLIPS + 2] = {0};
+    mc_rng rng;
+    mc_rng_seed(&rng, 12345, 0);
+    double start = now_s();
+    fn(&rng, FLIPS, balls, counts);
+    double rate = balls / (now_s() - start);
+    double mean = 0.0;
+    for(int k = 0; k <= FLIPS; k++)
+        mean += (double)counts[k] * k;
+    printf("%-10s %10.1f %8.1fx %10.4f\n", name, rate / 1e6, baseline > 0 ? rate / baseline : 1.0, mean / balls);
+    return rate;
+}
+
+static bool self_test(const char *name, sampler fn, unsigned flips, uint64_t balls, bool expectPass)
+{
+    uint64_t counts[BINOMIAL_MAX_FLIPS + 2] = {0};
+    mc_rng rng;
+    mc_rng_seed(&rng, 777, flips);
+    fn(&rng, flips, balls, counts);
+    double statistic = binomial_chi_square(counts, flips);
+    double p = chi_square_p_value(statistic, flips);
+    bool passed = p >= ALPHA;
+    printf("%-10s %5u %12.2f %10.4f  %s\n", name, flips, statistic, p,
+           passed == expectPass ? (passed ? "OK" : "OK (odrzucony)") : "BŁĄD");
+    return passed == expectPass;
+}
+
+int main(int argc, char **argv)
+{
+    long mballs = argc >= 2 ? atol(argv[1]) : DEFAULT_MBALLS;
+    if(mballs <= 0)
+    {
+        printf("Usage: %s [balls in millions]\n", argv[0]);
+        exit(EXIT_FAILURE);
+    }
+    uint64_t balls = (uint64_t)mballs * 1000000;
+
+    printf("%ld M kulek, %d rzutów na kulkę, generator: %s\n", mballs, FLIPS, mc_impl_name());
+    printf("losowanie  Mkulek/s  przyspiesz.   średnia\n");
+    // pierwotna pętla jest wielokrotnie wolniejsza - mniej kulek, ten sam wynik na sekundę
+    double baseline = measure("rand_r", rand_sampler, balls / 8, 0.0);
+    measure("popcount", popcount_sampler, balls, baseline);
+    measure("batch", batch_sampler, balls, baseline);
+
+    printf("\nTest chi-kwadrat, %d kulek, odrzucenie przy p < %g\n", TEST_BALLS, ALPHA);
+    printf("losowanie  rzuty         chi2          p\n");
+    static const unsigned flipsList[] = { 1, 4, FLIPS, BINOMIAL_MAX_FLIPS };
+    bool ok = true;
+    for(size_t i = 0; i < sizeof(flipsList) / sizeof(flipsList[0]); i++)
+    {
+        ok &= self_test("popcount", popcount_sampler, flipsList[i], TEST_BALLS, true);
+        ok &= self_test("batch", batch_sampler, flipsList[i], TEST_BALLS, true);
+    }
+    // kontrola mocy testu: przesunięty rozkład musi zostać odrzucony
+    ok &= self_test("biased", biased_sampler, FLIPS, TEST_BALLS, false);
+    printf("%s\n", ok ? "PASS" : "FAIL");
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
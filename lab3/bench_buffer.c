@@ -0,0 +1,167 @@
+#define _GNU_SOURCE
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "circular_buffer.h"
+
+// Mikrobenchmark bufora cyklicznego: przekazania/s i opóźnienie p50/p99
+// między enqueue a dequeue dla każdego trybu bufora.
+// Użycie: ./bench_buffer [liczba elementów] [producenci] [konsumenci] [rozmiar serii]
+
+#define DEFAULT_ITEMS 20000
+#define DEFAULT_PRODUCERS 1
+#define DEFAULT_CONSUMERS 4
+#define DEFAULT_BATCH 1
+#define MAX_BATCH 1024
+
+#define ERR(source) (perror(source), fprintf(stderr, "%s:%d\n", __FILE__, __LINE__), exit(EXIT_FAILURE))
+
+typedef struct bench_args {
+    pthread_t tid;
+    circular_buffer *buffer;
+    uint64_t *stamps;    // czas wstawienia elementu i (ns)
+    int first, last;     // zakres elementów producenta
+    int batch;           // elementy przenoszone jednym wywołaniem *_many
+    uint64_t *latencies; // opóźnienia zebrane przez konsumenta
+    int latencyCount;
+} bench_args_t;
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static int cmp_u64(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+void* producer_func(void *voidArgs)
+{
+    bench_args_t *args = voidArgs;
+    char *items[MAX_BATCH];
+    for(int i = args->first; i < args->last; )
+    {
+        int n = 0;
+        uint64_t t = now_ns();
+        // elementem jest wskaźnik na znacznik czasu - bez alokacji w pętli
+        for(; n < args->batch && i < args->last; n++, i++)
+        {
+            args->stamps[i] = t;
+            items[n] = (char *)&args->stamps[i];
+        }
+        if(n == 1)
+            circular_buffer_enqueue(args->buffer, items[0]);
+        else
+            circular_buffer_enqueue_many(args->buffer, items, n);
+    }
+    return NULL;
+}
+
+void* consumer_func(void *voidArgs)
+{
+    bench_args_t *args = voidArgs;
+    char *items[MAX_BATCH];
+    size_t n;
+    if(args->batch == 1)
+    {
+        while((items[0] = circular_buffer_dequeue(args->buffer)) != NULL)
+            args->latencies[args->latencyCount++] = now_ns() - *(uint64_t *)items[0];
+        return NULL;
+    }
+    while((n = circular_buffer_dequeue_many(args->buffer, items, args->batch)) > 0)
+    {
+        uint64_t t = now_ns();
+        for(size_t i = 0; i < n; i++)
+            args->latencies[args->latencyCount++] = t - *(uint64_t *)items[i];
+    }
+    return NULL;
+}
+
+void run_mode(circular_buffer_mode mode, int items, int producers, int consumers, int batch)
+{
+    circular_buffer *buffer = circular_buffer_init(NULL, mode, BUFFER_SIZE);
+    uint64_t *stamps = malloc(sizeof(uint64_t) * items);
+    uint64_t *latencies = malloc(sizeof(uint64_t) * items);
+    bench_args_t *args = calloc(producers + consumers, sizeof(bench_args_t));
+    if(stamps == NULL || latencies == NULL || args == NULL)
+        ERR("malloc");
+
+    uint64_t start = now_ns();
+    for(int i = 0; i < consumers; i++)
+    {
+        bench_args_t *a = &args[producers + i];
+        a->buffer = buffer;
+        a->batch = batch;
+        a->latencies = malloc(sizeof(uint64_t) * items);
+        if(a->latencies == NULL)
+            ERR("malloc");
+        if(pthread_create(&a->tid, NULL, consumer_func, a) != 0)
+            ERR("pthread_create");
+    }
+    for(int i = 0; i < producers; i++)
+    {
+        bench_args_t *a = &args[i];
+        a->buffer = buffer;
+        a->batch = batch;
+        a->stamps = stamps;
+        a->first = (int)((long)items * i / producers);
+        a->last = (int)((long)items * (i + 1) / producers);
+        if(pthread_create(&a->tid, NULL, producer_func, a) != 0)
+            ERR("pthread_create");
+    }
+    for(int i = 0; i < producers; i++)
+        if(pthread_join(args[i].tid, NULL) != 0)
+            ERR("pthread_join");
+    circular_buffer_shutdown(buffer);
+
+    int total = 0;
+    for(int i = producers; i < producers + consumers; i++)
+    {
+        if(pthread_join(args[i].tid, NULL) != 0)
+            ERR("pthread_join");
+        memcpy(latencies + total, args[i].latencies, sizeof(uint64_t) * args[i].latencyCount);
+        total += args[i].latencyCount;
+        free(args[i].latencies);
+    }
+    double seconds = (now_ns() - start) / 1e9;
+    if(total != items)
+        fprintf(stderr, "%s: lost items (%d of %d)\n", circular_buffer_mode_name(mode), total, items);
+
+    qsort(latencies, total, sizeof(uint64_t), cmp_u64);
+    printf("%-10s %12.0f %12.1f %12.1f\n", circular_buffer_mode_name(mode), total / seconds,
+           latencies[total / 2] / 1e3, latencies[(int)(total * 0.99)] / 1e3);
+
+    circular_buffer_deinit(buffer);
+    free(args);
+    free(latencies);
+    free(stamps);
+}
+
+int main(int argc, char **argv)
+{
+    int items = argc >= 2 ? atoi(argv[1]) : DEFAULT_ITEMS;
+    int producers = argc >= 3 ? atoi(argv[2]) : DEFAULT_PRODUCERS;
+    int consumers = argc >= 4 ? atoi(argv[3]) : DEFAULT_CONSUMERS;
+    int batch = argc >= 5 ? atoi(argv[4]) : DEFAULT_BATCH;
+    if(items <= 0 || producers <= 0 || consumers <= 0 || batch <= 0 || batch > MAX_BATCH)
+    {
+        printf("Usage: %s [items] [producers] [consumers] [batch <= %d]\n", argv[0], MAX_BATCH);
+        exit(EXIT_FAILURE);
+    }
+
+    printf("items=%d producers=%d consumers=%d batch=%d\n", items, producers, consumers, batch);
+    printf("%-10s %12s %12s %12s\n", "mode", "handoffs/s", "p50 [us]", "p99 [us]");
+    run_mode(CB_MODE_POLLING, items, producers, consumers, batch);
+    run_mode(CB_MODE_BLOCKING, items, producers, consumers, batch);
+    if(producers == 1 && consumers == 1)
+        run_mode(CB_MODE_SPSC, items, producers, consumers, batch);
+    run_mode(CB_MODE_MPMC, items, producers, consumers, batch);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,118 @@
+#define _GNU_SOURCE
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "circular_buffer.h"
+
+// Przegląd pojemności kolejki (16..64K) względem liczby pracowników.
+// Skaner produkuje ścieżki seriami (jedno przejście readdir), pracownicy
+// "przetwarzają" każdy element przez zadany czas. Wynik w CSV:
+// przepustowość oraz odsetek czasu, który skaner spędził zablokowany na pełnej kolejce.
+// Użycie: ./bench_capacity [elementy] [ns skanera/element] [ns pracownika/element] [seria] [max pracowników] [tryb]
+
+#define DEFAULT_ITEMS 200000
+#define DEFAULT_SCAN_NS 200
+#define DEFAULT_WORK_NS 2000
+#define DEFAULT_BURST 256
+#define DEFAULT_MAX_WORKERS 8
+#define MIN_CAPACITY 16
+#define MAX_CAPACITY 65536
+
+#define ERR(source) (perror(source), fprintf(stderr, "%s:%d\n", __FILE__, __LINE__), exit(EXIT_FAILURE))
+
+typedef struct worker_args {
+    pthread_t tid;
+    circular_buffer *buffer;
+    long workNs;
+} worker_args_t;
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// symulacja pracy bez oddawania procesora
+static void burn_ns(long ns)
+{
+    uint64_t end = now_ns() + ns;
+    while(now_ns() < end)
+        ;
+}
+
+void* worker_func(void *voidArgs)
+{
+    worker_args_t *args = voidArgs;
+    while(circular_buffer_dequeue(args->buffer) != NULL)
+        burn_ns(args->workNs);
+    return NULL;
+}
+
+void run(circular_buffer_mode mode, size_t capacity, int workers, int items, long scanNs, long workNs, int burst)
+{
+    static char dummy; // elementy nie są dereferencjonowane
+    circular_buffer *buffer = circular_buffer_init(NULL, mode, capacity);
+    worker_args_t *args = malloc(sizeof(worker_args_t) * workers);
+    if(args == NULL)
+        ERR("malloc");
+
+    uint64_t start = now_ns();
+    for(int i = 0; i < workers; i++)
+    {
+        args[i].buffer = buffer;
+        args[i].workNs = workNs;
+        if(pthread_create(&args[i].tid, NULL, worker_func, &args[i]) != 0)
+            ERR("pthread_create");
+    }
+
+    uint64_t stalled = 0;
+    for(int done = 0; done < items; )
+    {
+        int n = items - done < burst ? items - done : burst;
+        burn_ns(scanNs * n); // jedno przejście readdir
+        for(int i = 0; i < n; i++)
+        {
+            uint64_t t = now_ns();
+            circular_buffer_enqueue(buffer, &dummy);
+            stalled += now_ns() - t;
+        }
+        done += n;
+    }
+    circular_buffer_shutdown(buffer);
+
+    for(int i = 0; i < workers; i++)
+        if(pthread_join(args[i].tid, NULL) != 0)
+            ERR("pthread_join");
+    uint64_t elapsed = now_ns() - start;
+
+    printf("%s,%zu,%d,%.0f,%.1f\n", circular_buffer_mode_name(mode), buffer->capacity, workers,
+           items / (elapsed / 1e9), 100.0 * stalled / elapsed);
+
+    circular_buffer_deinit(buffer);
+    free(args);
+}
+
+int main(int argc, char **argv)
+{
+    int items = argc >= 2 ? atoi(argv[1]) : DEFAULT_ITEMS;
+    long scanNs = argc >= 3 ? atol(argv[2]) : DEFAULT_SCAN_NS;
+    long workNs = argc >= 4 ? atol(argv[3]) : DEFAULT_WORK_NS;
+    int burst = argc >= 5 ? atoi(argv[4]) : DEFAULT_BURST;
+    int maxWorkers = argc >= 6 ? atoi(argv[5]) : DEFAULT_MAX_WORKERS;
+    circular_buffer_mode mode = CB_MODE_BLOCKING;
+    if(items <= 0 || scanNs < 0 || workNs < 0 || burst <= 0 || maxWorkers <= 0
+       || (argc >= 7 && !circular_buffer_parse_mode(argv[6], &mode)) || mode == CB_MODE_SPSC)
+    {
+        printf("Usage: %s [items] [scan ns/item] [work ns/item] [burst] [max workers] [polling|blocking|mpmc]\n", argv[0]);
+        exit(EXIT_FAILURE);
+    }
+
+    printf("mode,capacity,workers,items_per_s,scanner_stall_pct\n");
+    for(size_t capacity = MIN_CAPACITY; capacity <= MAX_CAPACITY; capacity *= 4)
+        for(int workers = 1; workers <= maxWorkers; workers *= 2)
+            run(mode, capacity, workers, items, scanNs, workNs, burst);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,105 @@
+#define _GNU_SOURCE
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "letter_stats.h"
+
+// Koszt dodania liczników jednego pliku do globalnego histogramu przy rosnącej
+// liczbie wątków: mutex na literę, atomowe fetch-add i prywatne histogramy.
+// Każdy wątek dodaje `files` histogramów; wynik w plikach/s dla całego procesu.
+// Użycie: ./bench_counters [pliki na wątek] [maks. wątków]
+
+#define DEFAULT_FILES 200000
+#define DEFAULT_MAX_THREADS 16
+
+#define ERR(source) (perror(source), fprintf(stderr, "%s:%d\n", __FILE__, __LINE__), exit(EXIT_FAILURE))
+
+typedef struct bench_args {
+    pthread_t tid;
+    letter_stats *stats;
+    int thread;
+    long files;
+    const uint64_t *counts;
+    pthread_barrier_t *start;
+} bench_args_t;
+
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void* adder(void *voidArgs)
+{
+    bench_args_t *args = voidArgs;
+    pthread_barrier_wait(args->start);
+    for(long i = 0; i < args->files; i++)
+        letter_stats_add(args->stats, args->thread, args->counts, 4096);
+    return NULL;
+}
+
+static void run(letter_stats_mode mode, int threads, long files, const uint64_t *counts)
+{
+    letter_stats *stats = letter_stats_init(mode, threads);
+    if(stats == NULL)
+        ERR("letter_stats_init");
+    bench_args_t *args = malloc(sizeof(bench_args_t) * threads);
+    if(args == NULL)
+        ERR("malloc");
+    pthread_barrier_t start;
+    pthread_barrier_init(&start, NULL, threads + 1);
+
+    for(int i = 0; i < threads; i++)
+    {
+        args[i] = (bench_args_t){ .stats = stats, .thread = i, .files = files, .counts = counts, .start = &start };
+        if(pthread_create(&args[i].tid, NULL, adder, &args[i]) != 0)
+            ERR("pthread_create");
+    }
+    double t = now_s();
+    pthread_barrier_wait(&start);
+    for(int i = 0; i < threads; i++)
+        pthread_join(args[i].tid, NULL);
+    t = now_s() - t;
+
+    letter_snapshot total;
+    letter_stats_snapshot(stats, &total);
+    bool ok = total.files == (uint64_t)files * threads;
+    for(int i = 0; i < LETTER_COUNT; i++)
+        ok = ok && total.counts[i] == counts[i] * files * threads;
+
+    printf("%-7s %3d %14.0f %10.1f %s\n", letter_stats_mode_name(mode), threads,
+           files * threads / t, t * 1e9 / (files * threads), ok ? "" : "MISMATCH");
+
+    pthread_barrier_destroy(&start);
+    free(args);
+    letter_stats_deinit(stats);
+}
+
+int main(int argc, char **argv)
+{
+    long files = argc >= 2 ? atol(argv[1]) : DEFAULT_FILES;
+    int maxThreads = argc >= 3 ? atoi(argv[2]) : DEFAULT_MAX_THREADS;
+    if(files <= 0 || maxThreads <= 0)
+    {
+        printf("Usage: %s [files per thread] [max threads]\n", argv[0]);
+        exit(EXIT_FAILURE);
+    }
+
+    // histogram typowego pliku tekstowego - prawie wszystkie litery niezerowe
+    uint64_t counts[LETTER_COUNT];
+    unsigned int seed = 12345;
+    for(int i = 0; i < LETTER_COUNT; i++)
+        counts[i] = rand_r(&seed) % 8 == 0 ? 0 : 1 + rand_r(&seed) % 200;
+
+    printf("%-7s %3s %14s %10s\n", "mode", "thr", "files/s", "ns/file");
+    for(int mode = LETTER_STATS_MUTEX; mode <= LETTER_STATS_LOCAL; mode++)
+    {
+        for(int threads = 1; threads <= maxThreads; threads *= 2)
+            run((letter_stats_mode)mode, threads, files, counts);
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,110 @@
+#define _GNU_SOURCE
+#include <ctype.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "letter_hist.h"
+
+// Przepustowość jądra histogramu liter (GB/s) w porównaniu z pętlą
+// isalpha/isupper z process_file, na losowym tekście o rozmiarze kilku MB.
+// Użycie: ./bench_hist [rozmiar w MB] [powtórzenia]
+
+#define DEFAULT_MB 16
+#define DEFAULT_REPEATS 20
+
+#define ERR(source) (perror(source), fprintf(stderr, "%s:%d\n", __FILE__, __LINE__), exit(EXIT_FAILURE))
+
+typedef void (*hist_func)(const unsigned char *data, size_t len, uint64_t counts[LETTER_COUNT]);
+
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Dotychczasowa pętla z process_file
+static void baseline_loop(const unsigned char *data, size_t len, uint64_t counts[LETTER_COUNT])
+{
+    for(size_t i = 0; i < len; i++)
+    {
+        char c = data[i];
+        if(isalpha(c))
+        {
+            int index;
+            if(isupper(c))
+                index = c - 'A';
+            else
+                index = c - 'a' + 26;
+            counts[index]++;
+        }
+    }
+}
+
+// Tekst podobny do prawdziwego: głównie małe litery, spacje, interpunkcja i końce linii
+static void fill_text(unsigned char *data, size_t len, unsigned int seed)
+{
+    static const char extra[] = "  \n.,;-!?0123456789";
+    for(size_t i = 0; i < len; i++)
+    {
+        int r = rand_r(&seed) % 100;
+        if(r < 70)
+            data[i] = 'a' + rand_r(&seed) % 26;
+        else if(r < 80)
+            data[i] = 'A' + rand_r(&seed) % 26;
+        else
+            data[i] = extra[rand_r(&seed) % (sizeof(extra) - 1)];
+    }
+}
+
+static void run(const char *name, hist_func f, const unsigned char *data, size_t len, int repeats, const uint64_t *expected)
+{
+    uint64_t counts[LETTER_COUNT];
+    double best = 1e30;
+    for(int r = 0; r < repeats; r++)
+    {
+        memset(counts, 0, sizeof(counts));
+        double t = now_s();
+        f(data, len, counts);
+        t = now_s() - t;
+        if(t < best)
+            best = t;
+    }
+    bool ok = expected == NULL || memcmp(counts, expected, sizeof(counts)) == 0;
+    printf("%-10s %8.2f GB/s %s\n", name, len / best / 1e9, ok ? "" : "MISMATCH");
+}
+
+int main(int argc, char **argv)
+{
+    int mb = argc >= 2 ? atoi(argv[1]) : DEFAULT_MB;
+    int repeats = argc >= 3 ? atoi(argv[2]) : DEFAULT_REPEATS;
+    if(mb <= 0 || repeats <= 0)
+    {
+        printf("Usage: %s [size in MB] [repeats]\n", argv[0]);
+        exit(EXIT_FAILURE);
+    }
+
+    size_t len = (size_t)mb << 20;
+    unsigned char *data = malloc(len);
+    if(data == NULL)
+        ERR("malloc");
+    fill_text(data, len, 12345);
+
+    uint64_t expected[LETTER_COUNT] = {0};
+    baseline_loop(data, len, expected);
+
+    printf("%d MB, best of %d runs, dispatch selects %s\n", mb, repeats, letter_hist_impl_name());
+    run("baseline", baseline_loop, data, len, repeats, NULL);
+    run("scalar", letter_hist_scalar, data, len, repeats, expected);
+#if defined(__x86_64__) || defined(__i386__)
+    run("sse2", letter_hist_sse2, data, len, repeats, expected);
+    if(letter_hist_avx2_supported())
+        run("avx2", letter_hist_avx2, data, len, repeats, expected);
+#endif
+    run("dispatch", letter_hist_count, data, len, repeats, expected);
+
+    free(data);
+    return EXIT_SUCCESS;
+}
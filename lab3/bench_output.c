@@ -0,0 +1,161 @@
+#define _GNU_SOURCE
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "letter_stats.h"
+#include "result_writer.h"
+
+// Wypisywanie wyników plików: printf pod wspólnym mutexem (linia i tabela 52 liter
+// po każdym pliku, jak wcześniej w process_file) w porównaniu z wątkiem zapisu
+// result_writer (writev) na poziomach 1 i 2. Wyjście idzie do /dev/null albo do
+// podanego pliku; wynik w plikach/s.
+// Użycie: ./bench_output [pliki na wątek] [maks. wątków] [plik wyjściowy]
+
+#define DEFAULT_FILES 20000
+#define DEFAULT_MAX_THREADS 8
+
+#define ERR(source) (perror(source), fprintf(stderr, "%s:%d\n", __FILE__, __LINE__), exit(EXIT_FAILURE))
+
+typedef enum output_mode { OUT_PRINTF, OUT_WRITER_FILES, OUT_WRITER_TABLES } output_mode;
+static const char *output_names[] = { "printf", "writer-1", "writer-2" };
+
+typedef struct bench_args {
+    pthread_t tid;
+    int thread;
+    long files;
+    output_mode mode;
+    letter_stats *letters;
+    const uint64_t *counts;
+    FILE *out;
+    pthread_mutex_t *mxPrint;
+    result_writer *writer;
+    pthread_barrier_t *start;
+} bench_args_t;
+
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void print_table(FILE *out, const uint64_t *counts)
+{
+    fprintf(out, "Wyniki:\n");
+    for(int i = 0; i < 26; i++)
+    {
+        if(counts[i] != 0)
+            fprintf(out, "%c=%lu ", 'A' + i, (unsigned long)counts[i]);
+    }
+    fprintf(out, "\n");
+    for(int i = 26; i < 52; i++)
+    {
+        if(counts[i] != 0)
+            fprintf(out, "%c=%lu ", 'a' + (i - 26), (unsigned long)counts[i]);
+    }
+    fprintf(out, "\n\n");
+}
+
+static void* producer(void *voidArgs)
+{
+    bench_args_t *args = voidArgs;
+    char path[64];
+    pthread_barrier_wait(args->start);
+    for(long i = 0; i < args->files; i++)
+    {
+        snprintf(path, sizeof(path), "/tmp/tree/d%d/plik%ld.txt", args->thread, i);
+        letter_stats_add(args->letters, args->thread, args->counts, 4096);
+        if(args->mode == OUT_PRINTF)
+        {
+            letter_snapshot snapshot;
+            pthread_mutex_lock(args->mxPrint);
+            letter_stats_snapshot(args->letters, &snapshot);
+            fprintf(args->out, "Pracownik nr %d zakończył zliczanie liter w pliku %s\n", args->thread + 1, path);
+            print_table(args->out, snapshot.counts);
+            pthread_mutex_unlock(args->mxPrint);
+        }
+        else
+            result_writer_push(args->writer, args->thread + 1, path);
+    }
+    return NULL;
+}
+
+static void run(output_mode mode, int threads, long files, const uint64_t *counts, const char *outPath)
+{
+    int fd = open(outPath, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if(fd == -1)
+        ERR("open");
+    FILE *out = fdopen(fd, "w");
+    if(out == NULL)
+        ERR("fdopen");
+    letter_stats *letters = letter_stats_init(LETTER_STATS_LOCAL, threads);
+    if(letters == NULL)
+        ERR("letter_stats_init");
+    result_writer *writer = NULL;
+    if(mode != OUT_PRINTF && (writer = result_writer_init(fd, mode == OUT_WRITER_FILES ? RW_FILES : RW_TABLES, letters)) == NULL)
+        ERR("result_writer_init");
+
+    pthread_mutex_t mxPrint = PTHREAD_MUTEX_INITIALIZER;
+    pthread_barrier_t start;
+    pthread_barrier_init(&start, NULL, threads + 1);
+    bench_args_t *args = malloc(sizeof(bench_args_t) * threads);
+    if(args == NULL)
+        ERR("malloc");
+    for(int i = 0; i < threads; i++)
+    {
+        args[i] = (bench_args_t){ .thread = i, .files = files, .mode = mode, .letters = letters, .counts = counts,
+                                  .out = out, .mxPrint = &mxPrint, .writer = writer, .start = &start };
+        if(pthread_create(&args[i].tid, NULL, producer, &args[i]) != 0)
+            ERR("pthread_create");
+    }
+
+    double t = now_s();
+    pthread_barrier_wait(&start);
+    for(int i = 0; i < threads; i++)
+        pthread_join(args[i].tid, NULL);
+    // czas obejmuje zapis wszystkiego, co zostało w buforach
+    if(writer != NULL)
+        result_writer_deinit(writer);
+    fflush(out);
+    t = now_s() - t;
+
+    off_t size = lseek(fd, 0, SEEK_END);
+    printf("%-9s %3d %12.0f %10.1f MiB\n", output_names[mode], threads, files * threads / t,
+           size > 0 ? size / 1048576.0 : 0.0);
+
+    fclose(out);
+    free(args);
+    pthread_barrier_destroy(&start);
+    pthread_mutex_destroy(&mxPrint);
+    letter_stats_deinit(letters);
+}
+
+int main(int argc, char **argv)
+{
+    long files = argc >= 2 ? atol(argv[1]) : DEFAULT_FILES;
+    int maxThreads = argc >= 3 ? atoi(argv[2]) : DEFAULT_MAX_THREADS;
+    const char *outPath = argc >= 4 ? argv[3] : "/dev/null";
+    if(files <= 0 || maxThreads <= 0)
+    {
+        printf("Usage: %s [files per thread] [max threads] [output file]\n", argv[0]);
+        exit(EXIT_FAILURE);
+    }
+
+    uint64_t counts[LETTER_COUNT];
+    unsigned int seed = 12345;
+    for(int i = 0; i < LETTER_COUNT; i++)
+        counts[i] = rand_r(&seed) % 8 == 0 ? 0 : 1 + rand_r(&seed) % 200;
+
+    printf("%-9s %3s %12s %14s\n", "output", "thr", "files/s", "written");
+    for(int mode = OUT_PRINTF; mode <= OUT_WRITER_TABLES; mode++)
+    {
+        for(int threads = 1; threads <= maxThreads; threads *= 2)
+            run((output_mode)mode, threads, files, counts, outPath);
+    }
+    return EXIT_SUCCESS;
+}
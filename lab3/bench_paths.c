@@ -0,0 +1,185 @@
+#define _GNU_SOURCE
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <time.h>
+#include "circular_buffer.h"
+#include "path_arena.h"
+
+// Udział alokatora w przekazywaniu ścieżek skaner -> pracownicy, jak w etap4:
+// producent formatuje serię ścieżek, kopiuje je i wstawia do bufora mpmc,
+// konsumenci czytają ścieżki i je zwalniają. Warianty: bez kopii (stały napis,
+// punkt odniesienia), strdup/free oraz path_arena. Pętle kopiowania i zwalniania
+// są mierzone czasem CPU wątku dla całej serii; po odjęciu wariantu bez kopii
+// (koszt samego pomiaru) daje to czas alokatora i jego udział w czasie CPU procesu.
+// Użycie: ./bench_paths [liczba ścieżek] [konsumenci] [rozmiar serii]
+
+#define DEFAULT_PATHS 500000
+#define DEFAULT_CONSUMERS 4
+#define DEFAULT_BATCH 16
+#define MAX_BATCH 256
+#define MAX_CONSUMERS 64
+#define REPEATS 3
+#define MAX_PATH_LEN 128
+
+#define ERR(source) (perror(source), fprintf(stderr, "%s:%d\n", __FILE__, __LINE__), exit(EXIT_FAILURE))
+
+typedef enum copy_mode { COPY_NONE, COPY_MALLOC, COPY_ARENA } copy_mode;
+
+static const char *mode_names[] = { "bez kopii", "strdup/free", "path_arena" };
+
+typedef struct bench_args {
+    pthread_t tid;
+    circular_buffer *buffer;
+    copy_mode mode;
+    size_t bytes;     // suma długości przeczytanych ścieżek - konsument dotyka każdej
+    uint64_t allocNs; // czas CPU w pętlach kopiowania (producent) lub zwalniania (konsument)
+} bench_args_t;
+
+typedef struct run_result {
+    double wall;
+    double cpu;       // użytkownika i systemu, wszystkie wątki
+    double allocCpu;  // czas pętli kopiowania i zwalniania
+} run_result;
+
+static char fixedPath[] = "/tmp/lab3_bench_tree/korytarz1/korytarz2/korytarz3/plik00000000.txt";
+
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static uint64_t thread_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static double process_cpu(void)
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1e6 + usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1e6;
+}
+
+void* consumer_func(void *voidArgs)
+{
+    bench_args_t *args = voidArgs;
+    char *items[MAX_BATCH];
+    size_t n;
+    while((n = circular_buffer_dequeue_many(args->buffer, items, MAX_BATCH)) > 0)
+    {
+        for(size_t i = 0; i < n; i++)
+            args->bytes += strlen(items[i]);
+        uint64_t t = thread_ns();
+        for(size_t i = 0; i < n; i++)
+        {
+            if(args->mode == COPY_MALLOC)
+                free(items[i]);
+            else if(args->mode == COPY_ARENA)
+                path_arena_release(items[i]);
+        }
+        args->allocNs += thread_ns() - t;
+    }
+    return NULL;
+}
+
+static void run(copy_mode mode, long paths, int consumers, int batch, path_arena *arena, run_result *result)
+{
+    circular_buffer *buffer = circular_buffer_init(NULL, CB_MODE_MPMC, 4096);
+    bench_args_t args[MAX_CONSUMERS];
+    for(int i = 0; i < consumers; i++)
+    {
+        args[i].buffer = buffer;
+        args[i].mode = mode;
+        args[i].bytes = 0;
+        args[i].allocNs = 0;
+        if(pthread_create(&args[i].tid, NULL, consumer_func, &args[i]) != 0)
+            ERR("pthread_create");
+    }
+
+    double start = now_s(), startCpu = process_cpu();
+    static char path[MAX_BATCH][MAX_PATH_LEN];
+    char *items[MAX_BATCH];
+    uint64_t allocNs = 0;
+    for(long first = 0; first < paths; first += batch)
+    {
+        int n = paths - first < batch ? paths - first : batch;
+        for(int i = 0; i < n; i++)
+        {
+            long k = first + i;
+            snprintf(path[i], MAX_PATH_LEN, "/tmp/lab3_bench_tree/korytarz%ld/korytarz%ld/korytarz%ld/plik%08ld.txt",
+                     k % 4, k / 4 % 4, k / 16 % 4, k);
+        }
+        uint64_t t = thread_ns();
+        for(int i = 0; i < n; i++)
+        {
+            if(mode == COPY_NONE)
+                items[i] = fixedPath;
+            else if(mode == COPY_MALLOC)
+                items[i] = strdup(path[i]);
+            else
+                items[i] = path_arena_strdup(arena, path[i]);
+        }
+        allocNs += thread_ns() - t;
+        if(items[n - 1] == NULL)
+            ERR("copy");
+        circular_buffer_enqueue_many(buffer, items, n);
+    }
+    circular_buffer_shutdown(buffer);
+    for(int i = 0; i < consumers; i++)
+    {
+        if(pthread_join(args[i].tid, NULL) != 0)
+            ERR("pthread_join");
+        allocNs += args[i].allocNs;
+    }
+    result->wall = now_s() - start;
+    result->cpu = process_cpu() - startCpu;
+    result->allocCpu = allocNs / 1e9;
+    circular_buffer_deinit(buffer);
+}
+
+int main(int argc, char **argv)
+{
+    long paths = argc >= 2 ? atol(argv[1]) : DEFAULT_PATHS;
+    int consumers = argc >= 3 ? atoi(argv[2]) : DEFAULT_CONSUMERS;
+    int batch = argc >= 4 ? atoi(argv[3]) : DEFAULT_BATCH;
+    if(paths <= 0 || consumers < 1 || consumers > MAX_CONSUMERS || batch < 1 || batch > MAX_BATCH)
+    {
+        printf("Usage: %s [paths] [consumers 1-%d] [batch 1-%d]\n", argv[0], MAX_CONSUMERS, MAX_BATCH);
+        exit(EXIT_FAILURE);
+    }
+
+    printf("%ld ścieżek, %d konsumentów, serie po %d, najlepszy z %d przebiegów\n", paths, consumers, batch, REPEATS);
+    double baseAlloc = 0;
+    for(copy_mode mode = COPY_NONE; mode <= COPY_ARENA; mode++)
+    {
+        path_arena *arena = path_arena_init();
+        if(arena == NULL)
+            ERR("path_arena_init");
+        run_result best = { .wall = 1e30 };
+        for(int r = 0; r < REPEATS; r++)
+        {
+            run_result result;
+            run(mode, paths, consumers, batch, arena, &result);
+            if(result.wall < best.wall)
+                best = result;
+        }
+        if(mode == COPY_NONE)
+            baseAlloc = best.allocCpu;
+        double alloc = best.allocCpu - baseAlloc;
+        printf("%-12s %7.1f ns/ścieżkę %9.0f ścieżek/s  alokator %6.1f ns/ścieżkę, %5.1f%% CPU",
+               mode_names[mode], best.wall * 1e9 / paths, paths / best.wall, alloc * 1e9 / paths, 100.0 * alloc / best.cpu);
+        if(mode == COPY_ARENA)
+            printf(", chunki: %lu przydzielone, %lu odzyskane", (unsigned long)arena->chunks, (unsigned long)arena->reused);
+        printf("\n");
+        path_arena_deinit(arena);
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,112 @@
+#define _GNU_SOURCE
+#include <math.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "monte_carlo.h"
+
+// Przepustowość estymacji PI z prog17: rand_r + sqrt (pierwotna pętla) oraz
+// xoshiro256** z testem bez sqrt, jądro przenośne i AVX2. Dla 1, 2, 4, ...
+// wątków podaje próbki/s łącznie i na rdzeń (łącznie / min(wątki, procesory)).
+// Użycie: ./bench_pi [próbki na wątek w milionach] [maks. liczba wątków]
+
+#define DEFAULT_MSAMPLES 50
+#define MAX_THREADS 256
+
+#define ERR(source) (perror(source), fprintf(stderr, "%s:%d\n", __FILE__, __LINE__), exit(EXIT_FAILURE))
+
+typedef uint64_t (*pi_kernel)(mc_rng *rng, uint64_t samples);
+
+typedef struct bench_args {
+    pthread_t tid;
+    pi_kernel kernel;
+    mc_rng rng;
+    uint64_t samples;
+    uint64_t inside;
+} __attribute__((aligned(64))) bench_args_t;
+
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Pętla z prog17 (pi_estimation); ziarno rand_r z pierwszego słowa stanu
+static uint64_t rand_sqrt_kernel(mc_rng *rng, uint64_t samples)
+{
+    unsigned int seed = (unsigned int)rng->s[0][0];
+    uint64_t inside = 0;
+    for(uint64_t i = 0; i < samples; i++)
+    {
+        double x = ((double)rand_r(&seed) / (double)RAND_MAX);
+        double y = ((double)rand_r(&seed) / (double)RAND_MAX);
+        if(sqrt(x * x + y * y) <= 1.0)
+            inside++;
+    }
+    return inside;
+}
+
+void* thread_func(void *voidArgs)
+{
+    bench_args_t *args = voidArgs;
+    args->inside = args->kernel(&args->rng, args->samples);
+    return NULL;
+}
+
+static void run(const char *name, pi_kernel kernel, uint64_t samples, int threads, int cpus)
+{
+    static bench_args_t args[MAX_THREADS];
+    double start = now_s();
+    for(int i = 0; i < threads; i++)
+    {
+        args[i].kernel = kernel;
+        args[i].samples = samples;
+        mc_rng_seed(&args[i].rng, 12345, i);
+        if(pthread_create(&args[i].tid, NULL, thread_func, &args[i]) != 0)
+            ERR("pthread_create");
+    }
+    uint64_t inside = 0;
+    for(int i = 0; i < threads; i++)
+    {
+        if(pthread_join(args[i].tid, NULL) != 0)
+            ERR("pthread_join");
+        inside += args[i].inside;
+    }
+    double elapsed = now_s() - start;
+    double total = (double)samples * threads;
+    int cores = threads < cpus ? threads : cpus;
+    printf("%-10s %4d %10.1f %12.1f %12.6f\n", name, threads, total / elapsed / 1e6, total / elapsed / 1e6 / cores,
+           4.0 * inside / total);
+}
+
+int main(int argc, char **argv)
+{
+    long msamples = argc >= 2 ? atol(argv[1]) : DEFAULT_MSAMPLES;
+    int cpus = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    int maxThreads = argc >= 3 ? atoi(argv[2]) : cpus;
+    if(msamples <= 0 || maxThreads < 1 || maxThreads > MAX_THREADS)
+    {
+        printf("Usage: %s [samples per thread in millions] [max threads 1-%d]\n", argv[0], MAX_THREADS);
+        exit(EXIT_FAILURE);
+    }
+    uint64_t samples = (uint64_t)msamples * 1000000;
+
+    printf("%ld M próbek na wątek, %d procesorów, jądro domyślne: %s\n", msamples, cpus, mc_impl_name());
+    printf("jądro      wątki  Mpróbek/s     na rdzeń           PI\n");
+    for(int threads = 1; threads <= maxThreads; threads *= 2)
+    {
+        // pierwotna pętla jest kilkadziesiąt razy wolniejsza - mniej próbek, ten sam wynik na sekundę
+        run("rand_r", rand_sqrt_kernel, samples / 16, threads, cpus);
+        run("scalar", mc_count_inside_scalar, samples, threads, cpus);
+#if defined(__x86_64__) || defined(__i386__)
+        if(mc_avx2_supported())
+            run("avx2", mc_count_inside_avx2, samples, threads, cpus);
+#endif
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,216 @@
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <ftw.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+// Uruchamia etap4 dla każdej pary (liczba wątków, kolejka) na podanym drzewie
+// i zapisuje wiersz CSV na każde uruchomienie: czas, pliki/s, MB/s oraz dane
+// z rusage procesu potomnego (czas użytkownika i systemu, przełączenia kontekstu,
+// maksymalny RSS). Wyjście etap4 idzie do /dev/null, uruchamiany jest z -v 0.
+// Opcje programu po ścieżce do etap4 są przekazywane bez zmian.
+// Użycie: ./bench_run [-t 1,2,4] [-q blocking,mpmc,ws] [-r repeats] [-o out.csv] directory etap4 [etap4 options]
+
+#define MAX_LIST 32
+#define MAX_ARGS 64
+
+#define ERR(source) (perror(source), fprintf(stderr, "%s:%d\n", __FILE__, __LINE__), exit(EXIT_FAILURE))
+
+typedef struct run_options {
+    char *threads[MAX_LIST];
+    int threadCount;
+    char *queues[MAX_LIST];
+    int queueCount;
+    int repeats;
+    const char *csvPath;
+    const char *root;
+    char **program;    // etap4 i jego dodatkowe opcje
+    int programArgs;
+} run_options;
+
+typedef struct run_result {
+    double wall;
+    int status;
+    struct rusage usage;
+} run_result;
+
+// Pliki liczone tak jak w dir_scan - regularne z ".txt" w nazwie
+static long treeFiles;
+static uint64_t treeBytes;
+
+static void usage(const char *name)
+{
+    fprintf(stderr, "Usage: %s [-t 1,2,4] [-q blocking,mpmc,ws] [-r repeats] [-o out.csv] directory etap4 [etap4 options]\n", name);
+    exit(EXIT_FAILURE);
+}
+
+// Dzieli listę po przecinkach w miejscu
+static int split_list(char *list, char **items)
+{
+    int count = 0;
+    for (char *save, *item = strtok_r(list, ",", &save); item != NULL; item = strtok_r(NULL, ",", &save))
+    {
+        if (count == MAX_LIST)
+            ERR("List too long");
+        items[count++] = item;
+    }
+    return count;
+}
+
+static void read_args(int argc, char **argv, run_options *options)
+{
+    static char defaultThreads[] = "1,2,4,8";
+    static char defaultQueues[] = "blocking,mpmc,ws";
+    options->threadCount = split_list(defaultThreads, options->threads);
+    options->queueCount = split_list(defaultQueues, options->queues);
+    options->repeats = 3;
+    options->csvPath = NULL;
+
+    int c;
+    // '+' - opcje etap4 za ścieżką programu nie są opcjami runnera
+    while ((c = getopt(argc, argv, "+t:q:r:o:")) != -1)
+    {
+        switch (c)
+        {
+            case 't':
+                options->threadCount = split_list(optarg, options->threads);
+                break;
+            case 'q':
+                options->queueCount = split_list(optarg, options->queues);
+                break;
+            case 'r':
+                options->repeats = atoi(optarg);
+                if (options->repeats < 1)
+                    ERR("Invalid repeat count");
+                break;
+            case 'o':
+                options->csvPath = optarg;
+                break;
+            default:
+                usage(argv[0]);
+        }
+    }
+    if (argc - optind < 2 || options->threadCount == 0 || options->queueCount == 0)
+        usage(argv[0]);
+    options->root = argv[optind];
+    options->program = argv + optind + 1;
+    options->programArgs = argc - optind - 1;
+    if (options->programArgs + 5 > MAX_ARGS)
+        ERR("Too many etap4 options");
+}
+
+static int count_entry(const char *path, const struct stat *st, int type, struct FTW *ftw)
+{
+    if (type == FTW_F && S_ISREG(st->st_mode) && strstr(path + ftw->base, ".txt") != NULL)
+    {
+        treeFiles++;
+        treeBytes += st->st_size;
+    }
+    return 0;
+}
+
+static double elapsed(const struct timespec *start, const struct timespec *end)
+{
+    return (end->tv_sec - start->tv_sec) + (end->tv_nsec - start->tv_nsec) / 1e9;
+}
+
+static double tv_seconds(const struct timeval *tv)
+{
+    return tv->tv_sec + tv->tv_usec / 1e6;
+}
+
+static void run_once(const run_options *options, const char *threads, const char *queue, run_result *result)
+{
+    char *argv[MAX_ARGS];
+    int n = 0;
+    for (int i = 0; i < options->programArgs; i++)
+        argv[n++] = options->program[i];
+    argv[n++] = "-v";
+    argv[n++] = "0";
+    argv[n++] = (char *)options->root;
+    argv[n++] = (char *)threads;
+    argv[n++] = (char *)queue;
+    argv[n] = NULL;
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    pid_t pid = fork();
+    if (pid == -1)
+        ERR("fork");
+    if (pid == 0)
+    {
+        int devNull = open("/dev/null", O_WRONLY);
+        if (devNull == -1 || dup2(devNull, STDOUT_FILENO) == -1)
+            ERR("/dev/null");
+        close(devNull);
+        execv(argv[0], argv);
+        ERR("execv");
+    }
+
+    // wait4 zwraca rusage tylko tego potomka
+    while (wait4(pid, &result->status, 0, &result->usage) == -1)
+    {
+        if (errno != EINTR)
+            ERR("wait4");
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    result->wall = elapsed(&start, &end);
+}
+
+int main(int argc, char **argv)
+{
+    run_options options;
+    read_args(argc, argv, &options);
+
+    if (nftw(options.root, count_entry, 16, FTW_PHYS) == -1)
+        ERR("nftw");
+    if (treeFiles == 0)
+    {
+        fprintf(stderr, "No .txt files in %s\n", options.root);
+        exit(EXIT_FAILURE);
+    }
+
+    FILE *csv = stdout;
+    if (options.csvPath != NULL && (csv = fopen(options.csvPath, "w")) == NULL)
+        ERR("fopen");
+    fprintf(csv, "threads,queue,run,wall_s,files,bytes,files_per_s,mb_per_s,user_s,sys_s,voluntary_cs,involuntary_cs,max_rss_kb,status\n");
+
+    // przebieg rozgrzewający - drzewo w pamięci podręcznej stron, tak jak w kolejnych pomiarach
+    run_result result;
+    run_once(&options, options.threads[0], options.queues[0], &result);
+
+    for (int q = 0; q < options.queueCount; q++)
+    {
+        for (int t = 0; t < options.threadCount; t++)
+        {
+            // spsc działa tylko z jednym pracownikiem
+            if (strcmp(options.queues[q], "spsc") == 0 && atoi(options.threads[t]) != 1)
+                continue;
+            for (int r = 1; r <= options.repeats; r++)
+            {
+                run_once(&options, options.threads[t], options.queues[q], &result);
+                int status = WIFEXITED(result.status) ? WEXITSTATUS(result.status) : 128 + WTERMSIG(result.status);
+                if (status != 0)
+                    fprintf(stderr, "%s %s %s: status %d\n", options.program[0], options.threads[t], options.queues[q], status);
+                fprintf(csv, "%s,%s,%d,%.6f,%ld,%lu,%.1f,%.2f,%.6f,%.6f,%ld,%ld,%ld,%d\n",
+                        options.threads[t], options.queues[q], r, result.wall, treeFiles, (unsigned long)treeBytes,
+                        treeFiles / result.wall, treeBytes / 1e6 / result.wall,
+                        tv_seconds(&result.usage.ru_utime), tv_seconds(&result.usage.ru_stime),
+                        result.usage.ru_nvcsw, result.usage.ru_nivcsw, result.usage.ru_maxrss, status);
+                fflush(csv);
+            }
+        }
+    }
+
+    if (csv != stdout && fclose(csv) == EOF)
+        ERR("fclose");
+    return EXIT_SUCCESS;
+}
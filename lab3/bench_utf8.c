@@ -0,0 +1,135 @@
+#define _GNU_SOURCE
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "letter_hist.h"
+#include "utf8_hist.h"
+
+// Przepustowość dekodera UTF-8 z alfabetem polskim w porównaniu ze ścieżką ASCII
+// (letter_hist_count) na tych samych danych: tekście czysto ASCII i tekście
+// z polskimi znakami diakrytycznymi. Dekoder dostaje cały bufor albo kawałki
+// po 1 KiB, jak z read w file_io. Cel: najwyżej 2x wolniej niż ASCII.
+// Użycie: ./bench_utf8 [rozmiar w MB] [powtórzenia]
+
+#define DEFAULT_MB 16
+#define DEFAULT_REPEATS 20
+#define READ_CHUNK 1024
+
+#define ERR(source) (perror(source), fprintf(stderr, "%s:%d\n", __FILE__, __LINE__), exit(EXIT_FAILURE))
+
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Głównie małe litery, spacje i interpunkcja; `diacritics` na 100 liter to polskie znaki
+static size_t fill_text(unsigned char *data, size_t len, int diacritics, unsigned int seed)
+{
+    static const char *polish[] = { "ą", "ć", "ę", "ł", "ń", "ó", "ś", "ź", "ż", "Ł", "Ś", "Ż" };
+    static const char extra[] = "  \n.,;-!?0123456789";
+    size_t i = 0;
+    while (i + 2 <= len)
+    {
+        int r = rand_r(&seed) % 100;
+        if (r < 80)
+        {
+            if (rand_r(&seed) % 100 < diacritics)
+            {
+                const char *c = polish[rand_r(&seed) % (sizeof(polish) / sizeof(polish[0]))];
+                memcpy(data + i, c, 2);
+                i += 2;
+            }
+            else
+                data[i++] = r < 70 ? 'a' + rand_r(&seed) % 26 : 'A' + rand_r(&seed) % 26;
+        }
+        else
+            data[i++] = extra[rand_r(&seed) % (sizeof(extra) - 1)];
+    }
+    return i;
+}
+
+static double run_ascii(const unsigned char *data, size_t len, int repeats, uint64_t counts[LETTER_COUNT])
+{
+    double best = 1e30;
+    for (int r = 0; r < repeats; r++)
+    {
+        memset(counts, 0, sizeof(uint64_t) * LETTER_COUNT);
+        double t = now_s();
+        letter_hist_count(data, len, counts);
+        t = now_s() - t;
+        if (t < best)
+            best = t;
+    }
+    return best;
+}
+
+static double run_utf8(const utf8_alphabet *alphabet, const unsigned char *data, size_t len, size_t chunk,
+                       int repeats, uint64_t counts[LETTER_COUNT])
+{
+    double best = 1e30;
+    for (int r = 0; r < repeats; r++)
+    {
+        utf8_hist hist;
+        if (!utf8_hist_init(&hist, alphabet))
+            ERR("utf8_hist_init");
+        double t = now_s();
+        for (size_t off = 0; off < len; off += chunk)
+            utf8_hist_count(&hist, data + off, len - off < chunk ? len - off : chunk);
+        utf8_hist_finish(&hist);
+        t = now_s() - t;
+        if (t < best)
+            best = t;
+        if (hist.invalid != 0)
+            printf("unexpected invalid sequences: %lu\n", (unsigned long)hist.invalid);
+        utf8_hist_ascii(&hist, counts);
+        utf8_hist_deinit(&hist);
+    }
+    return best;
+}
+
+static void compare(const char *name, const utf8_alphabet *alphabet, const unsigned char *data, size_t len, int repeats)
+{
+    uint64_t ascii[LETTER_COUNT], whole[LETTER_COUNT], chunked[LETTER_COUNT];
+    double tAscii = run_ascii(data, len, repeats, ascii);
+    double tWhole = run_utf8(alphabet, data, len, len, repeats, whole);
+    double tChunked = run_utf8(alphabet, data, len, READ_CHUNK, repeats, chunked);
+
+    // wszystkie litery ASCII są w alfabecie, więc ich liczniki muszą się zgadzać
+    bool ok = memcmp(ascii, whole, sizeof(ascii)) == 0 && memcmp(ascii, chunked, sizeof(ascii)) == 0;
+    printf("%-8s %-12s %8.2f GB/s\n", name, "ascii", len / tAscii / 1e9);
+    printf("%-8s %-12s %8.2f GB/s %5.2fx %s\n", name, "utf8", len / tWhole / 1e9, tWhole / tAscii, ok ? "" : "MISMATCH");
+    printf("%-8s %-12s %8.2f GB/s %5.2fx %s\n", name, "utf8-1KiB", len / tChunked / 1e9, tChunked / tAscii, ok ? "" : "MISMATCH");
+}
+
+int main(int argc, char **argv)
+{
+    int mb = argc >= 2 ? atoi(argv[1]) : DEFAULT_MB;
+    int repeats = argc >= 3 ? atoi(argv[2]) : DEFAULT_REPEATS;
+    if (mb <= 0 || repeats <= 0)
+    {
+        printf("Usage: %s [size in MB] [repeats]\n", argv[0]);
+        exit(EXIT_FAILURE);
+    }
+
+    size_t size = (size_t)mb << 20;
+    unsigned char *data = malloc(size);
+    if (data == NULL)
+        ERR("malloc");
+    utf8_alphabet *alphabet = utf8_alphabet_init(UTF8_ALPHABET_POLISH);
+    if (alphabet == NULL)
+        ERR("utf8_alphabet_init");
+
+    printf("%d MB, best of %d runs, ASCII path uses %s, times relative to ASCII\n", mb, repeats, letter_hist_impl_name());
+    size_t len = fill_text(data, size, 0, 12345);
+    compare("ascii", alphabet, data, len, repeats);
+    len = fill_text(data, size, 8, 12345);
+    compare("polish", alphabet, data, len, repeats);
+
+    utf8_alphabet_deinit(alphabet);
+    free(data);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,110 @@
+#include "binomial.h"
+#include <math.h>
+
+#define FILL_WORDS 256 // słowa losowane naraz przez binomial_fill, 2 KiB na stosie
+#define FIELD_ONES 0x0001000100010001ull
+
+unsigned binomial_sample(mc_rng *rng, unsigned flips)
+{
+    return __builtin_popcountll(mc_next(rng) & ((1ull << flips) - 1));
+}
+
+// Popcount każdego z czterech 16-bitowych pól; wynik (najwyżej 16) zostaje w młodszym bajcie pola
+static inline uint64_t field_popcount(uint64_t x)
+{
+    x = x - ((x >> 1) & 0x5555555555555555ull);
+    x = (x & 0x3333333333333333ull) + ((x >> 2) & 0x3333333333333333ull);
+    x = (x + (x >> 4)) & 0x0f0f0f0f0f0f0f0full;
+    return (x + (x >> 8)) & 0x00ff00ff00ff00ffull;
+}
+
+void binomial_fill(mc_rng *rng, unsigned flips, uint8_t *out, size_t count)
+{
+    uint64_t words[FILL_WORDS];
+    const uint64_t mask = ((1ull << flips) - 1) * FIELD_ONES;
+    while(count > 0)
+    {
+        size_t balls = count < FILL_WORDS * 4 ? count : FILL_WORDS * 4;
+        size_t n = (balls + 3) / 4;
+        mc_fill(rng, words, n);
+        // pełne słowa - pętla bez rozgałęzień, kompilator ją wektoryzuje
+        size_t full = balls / 4;
+        for(size_t i = 0; i < full; i++)
+        {
+            uint64_t c = field_popcount(words[i] & mask);
+            out[4 * i] = (uint8_t)c;
+            out[4 * i + 1] = (uint8_t)(c >> 16);
+            out[4 * i + 2] = (uint8_t)(c >> 32);
+            out[4 * i + 3] = (uint8_t)(c >> 48);
+        }
+        if(full < n)
+        {
+            uint64_t c = field_popcount(words[full] & mask);
+            for(size_t j = 0; j < balls % 4; j++)
+                out[4 * full + j] = (uint8_t)(c >> (16 * j));
+        }
+        out += balls;
+        count -= balls;
+    }
+}
+
+double binomial_chi_square(const uint64_t *counts, unsigned flips)
+{
+    uint64_t total = 0;
+    for(unsigned k = 0; k <= flips; k++)
+        total += counts[k];
+    double statistic = 0.0;
+    double choose = 1.0; // C(flips, k)
+    for(unsigned k = 0; k <= flips; k++)
+    {
+        double expected = total * ldexp(choose, -(int)flips);
+        double diff = counts[k] - expected;
+        statistic += diff * diff / expected;
+        choose = choose * (flips - k) / (k + 1);
+    }
+    return statistic;
+}
+
+// Regularyzowana dolna funkcja gamma P(a, x) z szeregu, dla x < a + 1
+static double gamma_series(double a, double x)
+{
+    double term = 1.0 / a, sum = term;
+    for(int n = 1; n < 1000 && fabs(term) > fabs(sum) * 1e-15; n++)
+    {
+        term *= x / (a + n);
+        sum += term;
+    }
+    return sum * exp(-x + a * log(x) - lgamma(a));
+}
+
+// Regularyzowana górna funkcja gamma Q(a, x) z ułamka łańcuchowego (metoda Lentza), dla x >= a + 1
+static double gamma_fraction(double a, double x)
+{
+    const double tiny = 1e-300;
+    double b = x + 1.0 - a, c = 1.0 / tiny, d = 1.0 / b, h = d;
+    for(int i = 1; i < 1000; i++)
+    {
+        double an = -i * (i - a);
+        b += 2.0;
+        d = an * d + b;
+        if(fabs(d) < tiny)
+            d = tiny;
+        c = b + an / c;
+        if(fabs(c) < tiny)
+            c = tiny;
+        d = 1.0 / d;
+        double delta = d * c;
+        h *= delta;
+        if(fabs(delta - 1.0) < 1e-15)
+            break;
+    }
+    return h * exp(-x + a * log(x) - lgamma(a));
+}
+
+double chi_square_p_value(double statistic, unsigned df)
+{
+    double a = df / 2.0, x = statistic / 2.0;
+    if(x <= 0.0)
+        return 1.0;
+    return x < a + 1.0 ? 1.0 - gamma_series(a, x) : gamma_fraction(a, x);
+}
@@ -0,0 +1,35 @@
+#ifndef BINOMIAL_H
+#define BINOMIAL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "monte_carlo.h"
+
+#define BINOMIAL_MAX_FLIPS 16 // one ball per 16-bit field of a random word in binomial_fill
+
+/**
+ * Number of heads in `flips` fair coin flips (1..BINOMIAL_MAX_FLIPS), i.e. a
+ * Binomial(flips, 1/2) sample: popcount of the low `flips` bits of one output.
+ */
+unsigned binomial_sample(mc_rng *rng, unsigned flips);
+
+/**
+ * Stores `count` Binomial(flips, 1/2) samples in out. Every 64-bit output gives
+ * four samples, one per 16-bit field, counted with a SWAR popcount; the words
+ * come from mc_fill, so the AVX2 generator is used when available.
+ */
+void binomial_fill(mc_rng *rng, unsigned flips, uint8_t *out, size_t count);
+
+/**
+ * Pearson's chi-square statistic of a histogram counts[0..flips] against
+ * Binomial(flips, 1/2) scaled to the total of the histogram.
+ */
+double binomial_chi_square(const uint64_t *counts, unsigned flips);
+
+/**
+ * Probability that a chi-square variable with `df` degrees of freedom is at
+ * least `statistic`. A tiny value means the samples do not follow the distribution.
+ */
+double chi_square_p_value(double statistic, unsigned df);
+
+#endif // BINOMIAL_H
@@ -1,107 +1,147 @@
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <pthread.h>
 #include <unistd.h>
+#include "pipeline.h"
 
-#define BUFFER_SIZE 10 // Rozmiar bufora
-#define SLEEP_TIME_MS 5 // Czas uśpienia podczas busy waiting
+// Przykładowy potok klatek: dekodowanie -> przekształcenie -> kodowanie.
+// Każdy etap ma własny ograniczony bufor i liczbę wątków; przekształcenie jest
+// najwolniejsze i nawet na dwóch wątkach zostaje wąskim gardłem, co pokazuje
+// tabela statystyk etapów wypisywana na końcu.
+// Użycie: ./buffer2 [liczba klatek] [ordered|unordered]
+
+#define BUFFER_SIZE 10 // Rozmiar bufora przed każdym etapem
+#define FRAME_COUNT 20 // Domyślna liczba klatek przesyłanych przez przykład
+#define DECODE_US 10000    // Symulowany czas dekodowania klatki
+#define TRANSFORM_US 30000 // ... przekształcenia
+#define ENCODE_US 5000     // ... kodowania
+#define TRANSFORM_WORKERS 2
+#define STAGE_COUNT 3
+#define STAGE_WORKERS (1 + TRANSFORM_WORKERS + 1)
+// Pełne bufory wszystkich etapów plus klatka u każdego wątku i u producenta - pula nigdy się nie wyczerpie
+#define POOL_SIZE (STAGE_COUNT * BUFFER_SIZE + STAGE_WORKERS + 1)
+#define POOL_EMPTY UINT32_MAX // Koniec listy wolnych klatek
 
 typedef struct {
-    int data; // Przykładowe dane w klatce
+    int data;   // Przykładowe dane w klatce
+    int pixels; // Wynik dekodowania, zmieniany przez przekształcenie
 } Frame;
 
+// Pula klatek o stałym rozmiarze; wolne klatki tworzą stos bez blokad (stos Treibera) na indeksach
 typedef struct {
-    Frame *buffer[BUFFER_SIZE]; // Tablica wskaźników na struktury Frame
-    int head;                  // Wskaźnik na miejsce wstawienia nowego elementu
-    int tail;                  // Wskaźnik na najstarszy element
-    int count;                 // Liczba elementów w buforze
-    pthread_mutex_t mutex;     // Mutex dla synchronizacji
-} CircularBuffer;
+    Frame frames[POOL_SIZE];
+    uint32_t next[POOL_SIZE]; // Indeks następnej wolnej klatki
+    uint64_t top;             // Młodsze 32 bity: indeks wierzchołka, starsze: licznik zmian chroniący przed ABA
+} FramePool;
 
-// Funkcja inicjalizująca bufor cykliczny
-void initBuffer(CircularBuffer *cb) {
-    cb->head = 0;
-    cb->tail = 0;
-    cb->count = 0;
-    pthread_mutex_init(&cb->mutex, NULL);
+// Funkcja inicjalizująca pulę - wszystkie klatki wolne
+void initPool(FramePool *pool) {
+    for (uint32_t i = 0; i < POOL_SIZE; i++)
+        pool->next[i] = i + 1 < POOL_SIZE ? i + 1 : POOL_EMPTY;
+    pool->top = 0;
 }
 
-// Funkcja dodająca element do bufora
-void push(CircularBuffer *cb, Frame *frame) {
+// Funkcja pobierająca wolną klatkę z puli; NULL, gdy wszystkie są w użyciu
+Frame *acquireFrame(FramePool *pool) {
+    uint64_t top = __atomic_load_n(&pool->top, __ATOMIC_ACQUIRE);
     while (1) {
-        pthread_mutex_lock(&cb->mutex);
-        if (cb->count < BUFFER_SIZE) {
-            cb->buffer[cb->head] = frame;
-            cb->head = (cb->head + 1) % BUFFER_SIZE;
-            cb->count++;
-            pthread_mutex_unlock(&cb->mutex);
-            return;
-        }
-        pthread_mutex_unlock(&cb->mutex);
-        usleep(SLEEP_TIME_MS * 1000); // Busy waiting
+        uint32_t index = (uint32_t)top;
+        if (index == POOL_EMPTY)
+            return NULL;
+        // next[index] może być już nieaktualny, jeśli inny wątek zdjął tę klatkę - wtedy licznik zmian nie pasuje i CAS się nie uda
+        uint32_t next = __atomic_load_n(&pool->next[index], __ATOMIC_RELAXED);
+        uint64_t newTop = ((top >> 32) + 1) << 32 | next;
+        if (__atomic_compare_exchange_n(&pool->top, &top, newTop, 1, __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE))
+            return &pool->frames[index];
     }
 }
 
-// Funkcja pobierająca element z bufora
-Frame *pop(CircularBuffer *cb) {
+// Funkcja oddająca klatkę do puli
+void releaseFrame(FramePool *pool, Frame *frame) {
+    uint32_t index = (uint32_t)(frame - pool->frames);
+    uint64_t top = __atomic_load_n(&pool->top, __ATOMIC_RELAXED);
     while (1) {
-        pthread_mutex_lock(&cb->mutex);
-        if (cb->count > 0) {
-            Frame *frame = cb->buffer[cb->tail];
-            cb->tail = (cb->tail + 1) % BUFFER_SIZE;
-            cb->count--;
-            pthread_mutex_unlock(&cb->mutex);
-            return frame;
-        }
-        pthread_mutex_unlock(&cb->mutex);
-        usleep(SLEEP_TIME_MS * 1000); // Busy waiting
+        __atomic_store_n(&pool->next[index], (uint32_t)top, __ATOMIC_RELAXED);
+        uint64_t newTop = ((top >> 32) + 1) << 32 | index;
+        if (__atomic_compare_exchange_n(&pool->top, &top, newTop, 1, __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+            return;
     }
 }
 
-// Funkcja zwalniająca zasoby bufora
-void destroyBuffer(CircularBuffer *cb) {
-    pthread_mutex_destroy(&cb->mutex);
+// Etap dekodowania
+void *decode(void *item, void *ctx) {
+    (void)ctx;
+    Frame *frame = item;
+    usleep(DECODE_US);
+    frame->pixels = frame->data * 10;
+    return frame;
 }
 
-// Przykładowy wątek producenta
-void *producer(void *arg) {
-    CircularBuffer *cb = (CircularBuffer *)arg;
-    for (int i = 0; i < 20; i++) {
-        Frame *frame = malloc(sizeof(Frame));
-        frame->data = i;
-        printf("Producent: Dodaję klatkę %d\n", i);
-        push(cb, frame);
-        usleep(100 * 1000); // Symulacja opóźnienia
-    }
-    return NULL;
+// Etap przekształcenia, kilka wątków naraz
+void *transform(void *item, void *ctx) {
+    (void)ctx;
+    Frame *frame = item;
+    usleep(TRANSFORM_US);
+    frame->pixels += 1;
+    return frame;
 }
 
-// Przykładowy wątek konsumenta
-void *consumer(void *arg) {
-    CircularBuffer *cb = (CircularBuffer *)arg;
-    for (int i = 0; i < 20; i++) {
-        Frame *frame = pop(cb);
-        printf("Konsument: Pobieram klatkę %d\n", frame->data);
-        free(frame); // Zwolnienie pamięci
-        usleep(150 * 1000); // Symulacja opóźnienia
-    }
+// Etap kodowania - ostatni, oddaje klatkę do puli i niczego nie przekazuje dalej
+void *encode(void *item, void *ctx) {
+    FramePool *pool = ctx;
+    Frame *frame = item;
+    usleep(ENCODE_US);
+    printf("Konsument: Koduję klatkę %d (%d)\n", frame->data, frame->pixels);
+    releaseFrame(pool, frame); // Klatka wraca do puli
     return NULL;
 }
 
-int main() {
-    CircularBuffer cb;
-    initBuffer(&cb);
-
-    pthread_t producerThread, consumerThread;
+int main(int argc, char **argv) {
+    int frameCount = argc >= 2 ? atoi(argv[1]) : FRAME_COUNT;
+    pipeline_order order = PIPELINE_ORDERED;
+    if (argc >= 3 && strcmp(argv[2], "unordered") == 0)
+        order = PIPELINE_UNORDERED;
+    else if (argc >= 3 && strcmp(argv[2], "ordered") != 0)
+        frameCount = 0;
+    if (frameCount <= 0) {
+        fprintf(stderr, "Usage: %s [frames] [ordered|unordered]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
 
-    // Tworzenie wątków producenta i konsumenta
-    pthread_create(&producerThread, NULL, producer, &cb);
-    pthread_create(&consumerThread, NULL, consumer, &cb);
+    static FramePool pool;
+    initPool(&pool);
+    pipeline *p = pipeline_init(0);
+    if (p == NULL)
+        return EXIT_FAILURE;
+    // kolejność ma znaczenie tylko dla etapów z kilkoma wątkami; kodowanie dostaje klatki tak, jak wyszły z przekształcenia
+    pipeline_add_stage(p, "dekodowanie", decode, NULL, 1, BUFFER_SIZE, order);
+    pipeline_add_stage(p, "przekształc.", transform, NULL, TRANSFORM_WORKERS, BUFFER_SIZE, order);
+    pipeline_add_stage(p, "kodowanie", encode, &pool, 1, BUFFER_SIZE, order);
+    if (!pipeline_start(p)) {
+        fprintf(stderr, "Nie udało się uruchomić potoku\n");
+        pipeline_deinit(p);
+        return EXIT_FAILURE;
+    }
 
-    // Oczekiwanie na zakończenie wątków
-    pthread_join(producerThread, NULL);
-    pthread_join(consumerThread, NULL);
+    // Wątek główny jest producentem; przy pełnym buforze dekodowania pipeline_submit czeka
+    for (int i = 0; i < frameCount; i++) {
+        Frame *frame = acquireFrame(&pool);
+        if (frame == NULL) {
+            fprintf(stderr, "Pula klatek wyczerpana\n");
+            exit(EXIT_FAILURE);
+        }
+        frame->data = i;
+        printf("Producent: Dodaję klatkę %d\n", i);
+        pipeline_submit(p, frame);
+    }
+    pipeline_close(p);
+    // Kodowanie niczego nie przekazuje dalej, więc pipeline_next tylko czeka na koniec wszystkich etapów
+    while (pipeline_next(p) != NULL)
+        ;
 
-    destroyBuffer(&cb);
+    pipeline_print_stats(p, stdout);
+    pipeline_deinit(p);
     return 0;
 }
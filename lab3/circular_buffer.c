@@ -1,84 +1,703 @@
 #include "circular_buffer.h"
+#include <errno.h>
 #include <pthread.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <string.h>
 #include <stdio.h>
 #include <unistd.h>
+#include <sched.h>
+#include <time.h>
 
 #define ERR(source) (perror(source), fprintf(stderr, "%s:%d\n", __FILE__, __LINE__), exit(EXIT_FAILURE))
 
-circular_buffer* circular_buffer_init(bool *quitFlag) 
+#define SPIN_TRIES 64 // ile prób bez blokowania zanim wątek zaśnie (tryby lock-free)
+
+#if defined(__x86_64__) || defined(__i386__)
+#define cpu_relax() __builtin_ia32_pause()
+#else
+#define cpu_relax() ((void)0)
+#endif
+
+static const char *mode_names[] = { "polling", "blocking", "spsc", "mpmc" };
+
+// ----- Instrumentacja (tylko z -DCB_STATS) -----
+
+#ifdef CB_STATS
+#define STAT_ADD(cb, field, n) __atomic_fetch_add(&(cb)->stats.field, (n), __ATOMIC_RELAXED)
+
+static uint64_t stat_now(void)
 {
-    circular_buffer *buffer = malloc(sizeof(circular_buffer));
-    if(buffer == NULL)
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+// Jedno oczekiwanie na miejsce (full) albo na elementy, od chwili start
+static void stat_wait(circular_buffer *cb, uint64_t start, bool full)
+{
+    uint64_t ns = stat_now() - start;
+    if(full)
+    {
+        STAT_ADD(cb, fullWaits, 1);
+        STAT_ADD(cb, fullWaitNs, ns);
+    }
+    else
+    {
+        STAT_ADD(cb, emptyWaits, 1);
+        STAT_ADD(cb, emptyWaitNs, ns);
+    }
+}
+
+static void stat_high_water(circular_buffer *cb, uint64_t count)
+{
+    uint64_t seen = __atomic_load_n(&cb->stats.highWater, __ATOMIC_RELAXED);
+    while(count > seen && !__atomic_compare_exchange_n(&cb->stats.highWater, &seen, count, true,
+                                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+        ;
+}
+#else
+#define STAT_ADD(cb, field, n) ((void)0)
+
+static inline uint64_t stat_now(void)
+{
+    return 0;
+}
+
+static inline void stat_wait(circular_buffer *cb, uint64_t start, bool full)
+{
+    (void)cb;
+    (void)start;
+    (void)full;
+}
+
+static inline void stat_high_water(circular_buffer *cb, uint64_t count)
+{
+    (void)cb;
+    (void)count;
+}
+#endif
+
+// Przejęcie mxBuffer w trybach z mutexem; z CB_STATS nieudany trylock liczy się jako rywalizacja
+static inline void cb_lock(circular_buffer *cb)
+{
+#ifdef CB_STATS
+    STAT_ADD(cb, lockAcquired, 1);
+    if(pthread_mutex_trylock(&cb->mxBuffer) == 0)
+        return;
+    STAT_ADD(cb, lockContended, 1);
+#endif
+    pthread_mutex_lock(&cb->mxBuffer);
+}
+
+static bool is_lock_free(circular_buffer *bufferArgs)
+{
+    return bufferArgs->mode == CB_MODE_SPSC || bufferArgs->mode == CB_MODE_MPMC;
+}
+
+// Najmniejsza potęga dwójki >= n; dla n powyżej najwyższego bitu zwraca najwyższy bit zamiast się zapętlić
+static size_t round_up_pow2(size_t n)
+{
+    size_t p = 1;
+    while(p < n && p <= SIZE_MAX / 2)
+        p <<= 1;
+    return p;
+}
+
+circular_buffer* circular_buffer_init(bool *quitFlag, circular_buffer_mode mode, size_t capacity)
+{
+    if(capacity > CB_MAX_CAPACITY)
+    {
+        errno = EINVAL;
+        return NULL;
+    }
+    circular_buffer *buffer;
+    // wyrównanie do linii cache, żeby pola producenta i konsumenta się nie współdzieliły
+    if(posix_memalign((void **)&buffer, CB_CACHE_LINE, sizeof(circular_buffer)) != 0)
+        ERR("posix_memalign");
+
+    buffer->capacity = round_up_pow2(capacity == 0 ? BUFFER_SIZE : capacity);
+    buffer->mask = buffer->capacity - 1;
+    buffer->buffer = malloc(sizeof(char *) * buffer->capacity);
+    buffer->sequence = NULL;
+    if(buffer->buffer == NULL)
         ERR("malloc");
+    if(mode == CB_MODE_MPMC)
+    {
+        buffer->sequence = malloc(sizeof(size_t) * buffer->capacity);
+        if(buffer->sequence == NULL)
+            ERR("malloc");
+        for(size_t i = 0; i < buffer->capacity; i++)
+            buffer->sequence[i] = i;
+    }
 
     buffer->head = 0;
     buffer->tail = 0;
     buffer->count = 0;
+    buffer->mode = mode;
+    buffer->closed = false;
     buffer->quitFlag = quitFlag;
-    
+    buffer->enqueuePos = 0;
+    buffer->cachedDequeuePos = 0;
+    buffer->activeProducers = 0;
+    buffer->dequeuePos = 0;
+    buffer->cachedEnqueuePos = 0;
+    buffer->emptyWaiters = 0;
+    buffer->fullWaiters = 0;
+    memset(&buffer->stats, 0, sizeof(buffer->stats));
+
     if(pthread_mutex_init(&buffer->mxBuffer, NULL) != 0)
     {
         free(buffer);
         ERR("pthread_mutex_init");
     }
+    if(pthread_cond_init(&buffer->notFull, NULL) != 0 || pthread_cond_init(&buffer->notEmpty, NULL) != 0)
+    {
+        free(buffer);
+        ERR("pthread_cond_init");
+    }
     return buffer;
 }
 
-void circular_buffer_deinit(circular_buffer *bufferArgs) 
+void circular_buffer_deinit(circular_buffer *bufferArgs)
 {
     if(bufferArgs == NULL)
         return;
 
+#ifdef CB_STATS
+    circular_buffer_print_stats(bufferArgs, stderr);
+#endif
+    pthread_cond_destroy(&bufferArgs->notFull);
+    pthread_cond_destroy(&bufferArgs->notEmpty);
     pthread_mutex_destroy(&bufferArgs->mxBuffer);
+    free(bufferArgs->sequence);
+    free(bufferArgs->buffer);
     free(bufferArgs);
 }
 
-void circular_buffer_enqueue(circular_buffer *bufferArgs, char *item) 
+// Czy czekający konsument powinien się poddać (bufor zamknięty albo ustawiona quitFlag)
+static bool should_quit(circular_buffer *bufferArgs)
+{
+    if(bufferArgs->closed)
+        return true;
+    return bufferArgs->mode == CB_MODE_POLLING && bufferArgs->quitFlag != NULL && *(bufferArgs->quitFlag);
+}
+
+// ----- Tryby lock-free (SPSC i MPMC) -----
+
+// Każda funkcja try_* przenosi do n elementów bez blokowania i zwraca ich liczbę.
+
+static size_t spsc_try_enqueue(circular_buffer *cb, char **items, size_t n)
+{
+    size_t pos = cb->enqueuePos; // tylko producent zapisuje enqueuePos
+    size_t space = cb->capacity - (pos - cb->cachedDequeuePos);
+    if(space < n)
+    {
+        cb->cachedDequeuePos = __atomic_load_n(&cb->dequeuePos, __ATOMIC_ACQUIRE);
+        space = cb->capacity - (pos - cb->cachedDequeuePos);
+    }
+    size_t k = n < space ? n : space;
+    for(size_t i = 0; i < k; i++)
+        cb->buffer[(pos + i) & cb->mask] = items[i];
+    __atomic_store_n(&cb->enqueuePos, pos + k, __ATOMIC_RELEASE);
+    return k;
+}
+
+static size_t spsc_try_dequeue(circular_buffer *cb, char **items, size_t n)
+{
+    size_t pos = cb->dequeuePos; // tylko konsument zapisuje dequeuePos
+    size_t ready = cb->cachedEnqueuePos - pos;
+    if(ready < n)
+    {
+        cb->cachedEnqueuePos = __atomic_load_n(&cb->enqueuePos, __ATOMIC_ACQUIRE);
+        ready = cb->cachedEnqueuePos - pos;
+    }
+    size_t k = n < ready ? n : ready;
+    for(size_t i = 0; i < k; i++)
+        items[i] = cb->buffer[(pos + i) & cb->mask];
+    __atomic_store_n(&cb->dequeuePos, pos + k, __ATOMIC_RELEASE);
+    return k;
+}
+
+// Kolejka Vyukova: slot o numerze sekwencyjnym pos jest wolny dla producenta,
+// pos + 1 oznacza gotowy element dla konsumenta. Seria k kolejnych wolnych
+// (lub gotowych) slotów jest zajmowana jednym CAS-em na pozycji.
+static size_t mpmc_try_enqueue(circular_buffer *cb, char **items, size_t n)
+{
+    size_t pos = __atomic_load_n(&cb->enqueuePos, __ATOMIC_RELAXED);
+    for(;;)
+    {
+        size_t k = 0;
+        while(k < n && __atomic_load_n(&cb->sequence[(pos + k) & cb->mask], __ATOMIC_ACQUIRE) == pos + k)
+            k++;
+        if(k == 0)
+        {
+            intptr_t dif = (intptr_t)__atomic_load_n(&cb->sequence[pos & cb->mask], __ATOMIC_ACQUIRE) - (intptr_t)pos;
+            if(dif < 0)
+                return 0; // bufor pełny
+            pos = __atomic_load_n(&cb->enqueuePos, __ATOMIC_RELAXED);
+            continue;
+        }
+        if(__atomic_compare_exchange_n(&cb->enqueuePos, &pos, pos + k, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+        {
+            for(size_t i = 0; i < k; i++)
+            {
+                cb->buffer[(pos + i) & cb->mask] = items[i];
+                __atomic_store_n(&cb->sequence[(pos + i) & cb->mask], pos + i + 1, __ATOMIC_RELEASE);
+            }
+            return k;
+        }
+        STAT_ADD(cb, casFailures, 1);
+    }
+}
+
+static size_t mpmc_try_dequeue(circular_buffer *cb, char **items, size_t n)
+{
+    size_t pos = __atomic_load_n(&cb->dequeuePos, __ATOMIC_RELAXED);
+    for(;;)
+    {
+        size_t k = 0;
+        while(k < n && __atomic_load_n(&cb->sequence[(pos + k) & cb->mask], __ATOMIC_ACQUIRE) == pos + k + 1)
+            k++;
+        if(k == 0)
+        {
+            intptr_t dif = (intptr_t)__atomic_load_n(&cb->sequence[pos & cb->mask], __ATOMIC_ACQUIRE) - (intptr_t)(pos + 1);
+            if(dif < 0)
+                return 0; // bufor pusty
+            pos = __atomic_load_n(&cb->dequeuePos, __ATOMIC_RELAXED);
+            continue;
+        }
+        if(__atomic_compare_exchange_n(&cb->dequeuePos, &pos, pos + k, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+        {
+            for(size_t i = 0; i < k; i++)
+            {
+                items[i] = cb->buffer[(pos + i) & cb->mask];
+                __atomic_store_n(&cb->sequence[(pos + i) & cb->mask], pos + i + cb->capacity, __ATOMIC_RELEASE);
+            }
+            return k;
+        }
+        STAT_ADD(cb, casFailures, 1);
+    }
+}
+
+static bool lf_is_full(circular_buffer *cb)
+{
+    size_t pos = __atomic_load_n(&cb->enqueuePos, __ATOMIC_SEQ_CST);
+    if(cb->mode == CB_MODE_SPSC)
+        return pos - __atomic_load_n(&cb->dequeuePos, __ATOMIC_SEQ_CST) == cb->capacity;
+    // w MPMC slot jest wolny dopiero, gdy konsument odda jego numer sekwencyjny
+    return __atomic_load_n(&cb->sequence[pos & cb->mask], __ATOMIC_SEQ_CST) != pos;
+}
+
+static bool lf_is_empty(circular_buffer *cb)
+{
+    if(cb->mode == CB_MODE_SPSC)
+        return __atomic_load_n(&cb->enqueuePos, __ATOMIC_SEQ_CST) == __atomic_load_n(&cb->dequeuePos, __ATOMIC_SEQ_CST);
+    // w MPMC pozycja może być zajęta, zanim element zostanie opublikowany
+    size_t pos = __atomic_load_n(&cb->dequeuePos, __ATOMIC_SEQ_CST);
+    return __atomic_load_n(&cb->sequence[pos & cb->mask], __ATOMIC_SEQ_CST) != pos + 1;
+}
+
+// Zamknięty bufor jest opróżniony dopiero, gdy żaden producent nie jest w trakcie wstawiania.
+// Samo lf_is_empty nie wystarcza: producent MPMC mógł zająć pozycję bez opublikowania elementu,
+// a każdy producent mógł sprawdzić closed przed zamknięciem i wstawić element po nim.
+// Producent zwiększa activeProducers przed sprawdzeniem closed (SEQ_CST), więc albo zobaczy
+// zamknięcie, albo konsument zobaczy jego licznik i będzie czekał na element.
+static bool lf_drained(circular_buffer *cb)
+{
+    return __atomic_load_n(&cb->closed, __ATOMIC_SEQ_CST) && __atomic_load_n(&cb->activeProducers, __ATOMIC_SEQ_CST) == 0
+           && lf_is_empty(cb);
+}
+
+// Budzi uśpione wątki po drugiej stronie kolejki. Fence SEQ_CST paruje się
+// z inkrementacją licznika czekających w lf_park - albo śpiący zobaczy nowy
+// stan kolejki, albo my zobaczymy jego licznik.
+static void lf_wake(circular_buffer *cb, int *waiters, pthread_cond_t *cond, bool all)
+{
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if(__atomic_load_n(waiters, __ATOMIC_RELAXED) > 0)
+    {
+        pthread_mutex_lock(&cb->mxBuffer);
+        if(all)
+            pthread_cond_broadcast(cond);
+        else
+            pthread_cond_signal(cond);
+        pthread_mutex_unlock(&cb->mxBuffer);
+    }
+}
+
+static void lf_park(circular_buffer *cb, int *waiters, pthread_cond_t *cond, bool (*blocked)(circular_buffer *))
+{
+    pthread_mutex_lock(&cb->mxBuffer);
+    __atomic_add_fetch(waiters, 1, __ATOMIC_SEQ_CST);
+    while(blocked(cb) && !__atomic_load_n(&cb->closed, __ATOMIC_SEQ_CST))
+        pthread_cond_wait(cond, &cb->mxBuffer);
+    __atomic_sub_fetch(waiters, 1, __ATOMIC_SEQ_CST);
+    pthread_mutex_unlock(&cb->mxBuffer);
+}
+
+// Zapełnienie do statystyk - pozycje czytane bez synchronizacji, wynik przybliżony
+static uint64_t lf_occupancy(circular_buffer *cb)
+{
+    size_t enq = __atomic_load_n(&cb->enqueuePos, __ATOMIC_RELAXED);
+    size_t deq = __atomic_load_n(&cb->dequeuePos, __ATOMIC_RELAXED);
+    return enq > deq ? enq - deq : 0;
+}
+
+static size_t lf_enqueue_many(circular_buffer *cb, char **items, size_t n)
+{
+    size_t done = 0;
+    bool waiting = false; // czekanie liczy się od pierwszej nieudanej próby do postępu
+    uint64_t waitStart = 0;
+    STAT_ADD(cb, enqueueCalls, 1);
+    __atomic_add_fetch(&cb->activeProducers, 1, __ATOMIC_SEQ_CST);
+    for(int tries = 0; done < n; tries++)
+    {
+        if(__atomic_load_n(&cb->closed, __ATOMIC_SEQ_CST))
+            break;
+        size_t k = cb->mode == CB_MODE_SPSC ? spsc_try_enqueue(cb, items + done, n - done)
+                                            : mpmc_try_enqueue(cb, items + done, n - done);
+        if(k > 0)
+        {
+            if(waiting)
+                stat_wait(cb, waitStart, true);
+            waiting = false;
+            done += k;
+            tries = 0;
+            STAT_ADD(cb, enqueued, k);
+            stat_high_water(cb, lf_occupancy(cb));
+            lf_wake(cb, &cb->emptyWaiters, &cb->notEmpty, k > 1);
+            continue;
+        }
+        if(!waiting)
+        {
+            waiting = true;
+            waitStart = stat_now();
+        }
+        if(tries < SPIN_TRIES)
+            cpu_relax();
+        else
+            lf_park(cb, &cb->fullWaiters, &cb->notFull, lf_is_full);
+    }
+    __atomic_sub_fetch(&cb->activeProducers, 1, __ATOMIC_SEQ_CST);
+    if(waiting)
+        stat_wait(cb, waitStart, true);
+    return done;
+}
+
+static size_t lf_dequeue_many(circular_buffer *cb, char **items, size_t n)
+{
+    bool waiting = false;
+    uint64_t waitStart = 0;
+    STAT_ADD(cb, dequeueCalls, 1);
+    for(int tries = 0; ; tries++)
+    {
+        size_t k = cb->mode == CB_MODE_SPSC ? spsc_try_dequeue(cb, items, n) : mpmc_try_dequeue(cb, items, n);
+        if(k > 0)
+        {
+            if(waiting)
+                stat_wait(cb, waitStart, false);
+            STAT_ADD(cb, dequeued, k);
+            lf_wake(cb, &cb->fullWaiters, &cb->notFull, k > 1);
+            return k;
+        }
+        // zamknięty bufor zwraca 0 dopiero po opróżnieniu
+        if(lf_drained(cb))
+        {
+            if(waiting)
+                stat_wait(cb, waitStart, false);
+            return 0;
+        }
+        if(!waiting)
+        {
+            waiting = true;
+            waitStart = stat_now();
+        }
+        if(tries < SPIN_TRIES)
+            cpu_relax();
+        else
+            lf_park(cb, &cb->emptyWaiters, &cb->notEmpty, lf_is_empty);
+    }
+}
+
+// ----- Tryby z mutexem (polling i blocking) -----
+
+// Wywoływane z przejętym mxBuffer; wraca, gdy jest miejsce albo bufor zamknięto
+static void wait_for_space(circular_buffer *cb)
+{
+    if((size_t)cb->count < cb->capacity || cb->closed)
+        return;
+    uint64_t waitStart = stat_now();
+    while((size_t)cb->count == cb->capacity && !cb->closed) // bufor jest pełny
+    {
+        if(cb->mode == CB_MODE_BLOCKING)
+            pthread_cond_wait(&cb->notFull, &cb->mxBuffer);
+        else
+        {
+            pthread_mutex_unlock(&cb->mxBuffer);
+            usleep(5000); // wait 5ms (busy waiting)
+            cb_lock(cb);
+        }
+    }
+    stat_wait(cb, waitStart, true);
+}
+
+// Wywoływane z przejętym mxBuffer; false, gdy bufor jest pusty i zamknięty (lub ustawiono quitFlag)
+static bool wait_for_items(circular_buffer *cb)
+{
+    if(cb->count > 0)
+        return true;
+    uint64_t waitStart = stat_now();
+    bool ready = true;
+    while(cb->count == 0)
+    {
+        if(should_quit(cb))
+        {
+            ready = false;
+            break;
+        }
+        if(cb->mode == CB_MODE_BLOCKING)
+            pthread_cond_wait(&cb->notEmpty, &cb->mxBuffer);
+        else
+        {
+            pthread_mutex_unlock(&cb->mxBuffer);
+            usleep(5000); // Czekaj chwilę przed ponowną próbą
+            cb_lock(cb);
+        }
+    }
+    stat_wait(cb, waitStart, false);
+    return ready;
+}
+
+bool circular_buffer_enqueue(circular_buffer *bufferArgs, char *item)
 {
     if(bufferArgs == NULL)
         ERR("Nullptr passed as argument");
+    if(is_lock_free(bufferArgs))
+        return lf_enqueue_many(bufferArgs, &item, 1) == 1;
 
-    while(bufferArgs->count == BUFFER_SIZE) // bufor jest pełny
+    cb_lock(bufferArgs);
+    STAT_ADD(bufferArgs, enqueueCalls, 1);
+    wait_for_space(bufferArgs);
+    if(bufferArgs->closed)
     {
-        // ERR("Cannot add to a full buffer");
-        usleep(5000); // wait 5ms (busy waiting)
+        pthread_mutex_unlock(&bufferArgs->mxBuffer);
+        return false;
     }
 
-    pthread_mutex_lock(&bufferArgs->mxBuffer);
-    bufferArgs->buffer[bufferArgs->head] = item; // dodanie elementu na pozycji head 
+    bufferArgs->buffer[bufferArgs->head] = item; // dodanie elementu na pozycji head
 
-    bufferArgs->head = (bufferArgs->head + 1) % BUFFER_SIZE; // cykliczne przesunięcie head
+    bufferArgs->head = (bufferArgs->head + 1) & bufferArgs->mask; // cykliczne przesunięcie head
 
     bufferArgs->count++; // zwiększenie licznika elementów
+    STAT_ADD(bufferArgs, enqueued, 1);
+    stat_high_water(bufferArgs, bufferArgs->count);
+    if(bufferArgs->mode == CB_MODE_BLOCKING)
+        pthread_cond_signal(&bufferArgs->notEmpty);
     pthread_mutex_unlock(&bufferArgs->mxBuffer);
+    return true;
 }
 
-char* circular_buffer_dequeue(circular_buffer *bufferArgs) 
+char* circular_buffer_dequeue(circular_buffer *bufferArgs)
 {
-    while (true) {
-        pthread_mutex_lock(&bufferArgs->mxBuffer);
+    if(is_lock_free(bufferArgs))
+    {
+        char *item;
+        return lf_dequeue_many(bufferArgs, &item, 1) == 1 ? item : NULL;
+    }
+
+    cb_lock(bufferArgs);
+    STAT_ADD(bufferArgs, dequeueCalls, 1);
+    // Jeśli bufor jest pusty i zamknięty (lub ustawiono quitFlag), kończymy
+    if(!wait_for_items(bufferArgs))
+    {
+        pthread_mutex_unlock(&bufferArgs->mxBuffer);
+        return NULL;
+    }
+
+    char *item = bufferArgs->buffer[bufferArgs->tail]; // wydobycie elementu
 
-        // Sprawdź, czy bufor jest pusty
-        if (bufferArgs->count > 0) {
-            char *item = bufferArgs->buffer[bufferArgs->tail]; // wydobycie elementu
+    bufferArgs->tail = (bufferArgs->tail + 1) & bufferArgs->mask; // przesunięcie wskażnika tail
 
-            bufferArgs->tail = (bufferArgs->tail + 1) % BUFFER_SIZE; // przesunięcie wskażnika tail
+    bufferArgs->count--; // zmniejszenie liczby elementów
+    STAT_ADD(bufferArgs, dequeued, 1);
+    if(bufferArgs->mode == CB_MODE_BLOCKING)
+        pthread_cond_signal(&bufferArgs->notFull);
+    pthread_mutex_unlock(&bufferArgs->mxBuffer);
+    return item;
+}
+
+size_t circular_buffer_enqueue_many(circular_buffer *bufferArgs, char **items, size_t n)
+{
+    if(bufferArgs == NULL)
+        ERR("Nullptr passed as argument");
+    if(is_lock_free(bufferArgs))
+        return lf_enqueue_many(bufferArgs, items, n);
 
-            bufferArgs->count--; // zmniejszenie liczby elementów
-            pthread_mutex_unlock(&bufferArgs->mxBuffer);
-            return item;
+    size_t done = 0;
+    cb_lock(bufferArgs);
+    STAT_ADD(bufferArgs, enqueueCalls, 1);
+    while(done < n)
+    {
+        wait_for_space(bufferArgs);
+        if(bufferArgs->closed)
+            break;
+
+        // tyle, ile się zmieści, za jednym przejęciem mutexu
+        size_t k = bufferArgs->capacity - bufferArgs->count;
+        if(k > n - done)
+            k = n - done;
+        for(size_t i = 0; i < k; i++)
+        {
+            bufferArgs->buffer[bufferArgs->head] = items[done + i];
+            bufferArgs->head = (bufferArgs->head + 1) & bufferArgs->mask;
+        }
+        bufferArgs->count += k;
+        done += k;
+        STAT_ADD(bufferArgs, enqueued, k);
+        stat_high_water(bufferArgs, bufferArgs->count);
+        if(bufferArgs->mode == CB_MODE_BLOCKING)
+        {
+            if(k > 1)
+                pthread_cond_broadcast(&bufferArgs->notEmpty);
+            else
+                pthread_cond_signal(&bufferArgs->notEmpty);
         }
+    }
+    pthread_mutex_unlock(&bufferArgs->mxBuffer);
+    return done;
+}
 
-        // Jeśli bufor jest pusty, sprawdź quitFlag
-        if (*(bufferArgs->quitFlag)) {
-            pthread_mutex_unlock(&bufferArgs->mxBuffer);
-            return NULL;
+// Wywoływane z przejętym mxBuffer; pobiera do n elementów i budzi czekających producentów
+static size_t take_items(circular_buffer *cb, char **items, size_t n)
+{
+    size_t k = (size_t)cb->count < n ? (size_t)cb->count : n;
+    for(size_t i = 0; i < k; i++)
+    {
+        items[i] = cb->buffer[cb->tail];
+        cb->tail = (cb->tail + 1) & cb->mask;
+    }
+    cb->count -= k;
+    STAT_ADD(cb, dequeued, k);
+    if(cb->mode == CB_MODE_BLOCKING && k > 0)
+    {
+        if(k > 1)
+            pthread_cond_broadcast(&cb->notFull);
+        else
+            pthread_cond_signal(&cb->notFull);
+    }
+    return k;
+}
+
+size_t circular_buffer_dequeue_many(circular_buffer *bufferArgs, char **items, size_t n)
+{
+    if(is_lock_free(bufferArgs))
+        return lf_dequeue_many(bufferArgs, items, n);
+
+    cb_lock(bufferArgs);
+    STAT_ADD(bufferArgs, dequeueCalls, 1);
+    size_t k = wait_for_items(bufferArgs) ? take_items(bufferArgs, items, n) : 0;
+    pthread_mutex_unlock(&bufferArgs->mxBuffer);
+    return k;
+}
+
+size_t circular_buffer_try_dequeue_many(circular_buffer *bufferArgs, char **items, size_t n)
+{
+    STAT_ADD(bufferArgs, dequeueCalls, 1);
+    if(is_lock_free(bufferArgs))
+    {
+        size_t k = bufferArgs->mode == CB_MODE_SPSC ? spsc_try_dequeue(bufferArgs, items, n)
+                                                    : mpmc_try_dequeue(bufferArgs, items, n);
+        if(k > 0)
+        {
+            STAT_ADD(bufferArgs, dequeued, k);
+            lf_wake(bufferArgs, &bufferArgs->fullWaiters, &bufferArgs->notFull, k > 1);
         }
+        return k;
+    }
 
-        pthread_mutex_unlock(&bufferArgs->mxBuffer);
-        usleep(5000); // Czekaj chwilę przed ponowną próbą
+    cb_lock(bufferArgs);
+    size_t k = take_items(bufferArgs, items, n);
+    pthread_mutex_unlock(&bufferArgs->mxBuffer);
+    return k;
+}
+
+void circular_buffer_shutdown(circular_buffer *bufferArgs)
+{
+    pthread_mutex_lock(&bufferArgs->mxBuffer);
+    __atomic_store_n(&bufferArgs->closed, true, __ATOMIC_SEQ_CST);
+    // Budzimy wszystkich czekających - zamiast odpytywania quitFlag
+    pthread_cond_broadcast(&bufferArgs->notFull);
+    pthread_cond_broadcast(&bufferArgs->notEmpty);
+    pthread_mutex_unlock(&bufferArgs->mxBuffer);
+}
+
+int circular_buffer_count(circular_buffer *bufferArgs)
+{
+    if(is_lock_free(bufferArgs))
+    {
+        size_t deq = __atomic_load_n(&bufferArgs->dequeuePos, __ATOMIC_ACQUIRE);
+        size_t enq = __atomic_load_n(&bufferArgs->enqueuePos, __ATOMIC_ACQUIRE);
+        return enq > deq ? (int)(enq - deq) : 0;
+    }
+
+    pthread_mutex_lock(&bufferArgs->mxBuffer);
+    int count = bufferArgs->count;
+    pthread_mutex_unlock(&bufferArgs->mxBuffer);
+    return count;
+}
+
+bool circular_buffer_get_stats(circular_buffer *bufferArgs, circular_buffer_stats *stats)
+{
+#ifdef CB_STATS
+    // pola czytane pojedynczo - spójny zrzut nie jest potrzebny do diagnostyki
+    const uint64_t *src = (const uint64_t *)&bufferArgs->stats;
+    uint64_t *dst = (uint64_t *)stats;
+    for(size_t i = 0; i < sizeof(circular_buffer_stats) / sizeof(uint64_t); i++)
+        dst[i] = __atomic_load_n(&src[i], __ATOMIC_RELAXED);
+    return true;
+#else
+    (void)bufferArgs;
+    memset(stats, 0, sizeof(circular_buffer_stats));
+    return false;
+#endif
+}
+
+void circular_buffer_print_stats(circular_buffer *bufferArgs, FILE *out)
+{
+    circular_buffer_stats st;
+    if(!circular_buffer_get_stats(bufferArgs, &st))
+    {
+        fprintf(out, "Statystyki bufora niedostępne (kompilacja bez CB_STATS)\n");
+        return;
+    }
+    fprintf(out, "Bufor %s, pojemność %zu:\n", mode_names[bufferArgs->mode], bufferArgs->capacity);
+    fprintf(out, "  wstawione %lu w %lu wywołaniach, pobrane %lu w %lu wywołaniach\n",
+            (unsigned long)st.enqueued, (unsigned long)st.enqueueCalls,
+            (unsigned long)st.dequeued, (unsigned long)st.dequeueCalls);
+    fprintf(out, "  pełny: %lu oczekiwań, %.3f s; pusty: %lu oczekiwań, %.3f s\n",
+            (unsigned long)st.fullWaits, st.fullWaitNs / 1e9, (unsigned long)st.emptyWaits, st.emptyWaitNs / 1e9);
+    fprintf(out, "  mutex: %lu przejęć, %lu z rywalizacją (%.1f%%); nieudane CAS: %lu\n",
+            (unsigned long)st.lockAcquired, (unsigned long)st.lockContended,
+            st.lockAcquired > 0 ? 100.0 * st.lockContended / st.lockAcquired : 0.0, (unsigned long)st.casFailures);
+    fprintf(out, "  maksymalne zapełnienie: %lu/%zu\n", (unsigned long)st.highWater, bufferArgs->capacity);
+}
+
+bool circular_buffer_parse_mode(const char *name, circular_buffer_mode *mode)
+{
+    for(size_t i = 0; i < sizeof(mode_names) / sizeof(mode_names[0]); i++)
+    {
+        if(strcmp(name, mode_names[i]) == 0)
+        {
+            *mode = (circular_buffer_mode)i;
+            return true;
+        }
     }
-}
\ No newline at end of file
+    return false;
+}
+
+const char* circular_buffer_mode_name(circular_buffer_mode mode)
+{
+    return mode_names[mode];
+}
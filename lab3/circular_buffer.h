@@ -3,40 +3,148 @@
 
 #include <pthread.h>
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
 
-#define BUFFER_SIZE 16 // Example size for the buffer
+#define BUFFER_SIZE 16 // Default capacity of the buffer
+#define CB_MAX_CAPACITY ((size_t)1 << 24) // Largest accepted capacity; count is an int in the mutex modes
+#define CB_CACHE_LINE 64
+
+typedef enum circular_buffer_mode {
+    CB_MODE_POLLING,  // Sleeps 5 ms and retries while the buffer is full/empty
+    CB_MODE_BLOCKING, // Waits on the notFull/notEmpty condition variables
+    CB_MODE_SPSC,     // Lock-free ring, exactly one producer and one consumer
+    CB_MODE_MPMC      // Lock-free bounded ring with per-slot sequence numbers
+} circular_buffer_mode;
+
+/*
+ * Instrumentation counters. They are updated only when circular_buffer.c is
+ * built with -DCB_STATS (make CB_STATS=1), otherwise they stay zero and the
+ * hot paths contain no extra code.
+ */
+typedef struct circular_buffer_stats {
+    uint64_t enqueued;      // Items added
+    uint64_t dequeued;      // Items removed
+    uint64_t enqueueCalls;  // enqueue and enqueue_many calls
+    uint64_t dequeueCalls;
+    uint64_t fullWaits;     // Calls that found the buffer full and had to wait
+    uint64_t emptyWaits;    // Calls that found the buffer empty and had to wait
+    uint64_t fullWaitNs;    // Time producers spent waiting for space
+    uint64_t emptyWaitNs;   // Time consumers spent waiting for items
+    uint64_t lockAcquired;  // mxBuffer acquisitions in the mutex modes
+    uint64_t lockContended; // ... where pthread_mutex_trylock failed first
+    uint64_t casFailures;   // Lost CAS races in CB_MODE_MPMC
+    uint64_t highWater;     // Largest number of items seen in the buffer
+} circular_buffer_stats;
 
 typedef struct circular_buffer {
-    char *buffer[BUFFER_SIZE]; // Array of strings (file paths)
+    char **buffer;             // Array of strings (file paths)
+    size_t *sequence;          // Per-slot sequence numbers (CB_MODE_MPMC only)
+    size_t capacity;           // Number of slots, always a power of two
+    size_t mask;               // capacity - 1, used to wrap indices
     int head;                  // Points to the next free slot for enqueue
     int tail;                  // Points to the next available item for dequeue
     int count;                 // Number of items currently in the buffer
     pthread_mutex_t mxBuffer;  // Mutex for synchronizing buffer access
-    bool *quitFlag; 
+    pthread_cond_t notFull;    // Signalled after a dequeue (blocking mode)
+    pthread_cond_t notEmpty;   // Signalled after an enqueue (blocking mode)
+    circular_buffer_mode mode;
+    bool closed;               // Set by circular_buffer_shutdown
+    bool *quitFlag;
+
+    // Lock-free modes: producer and consumer state live on separate cache lines
+    size_t enqueuePos __attribute__((aligned(CB_CACHE_LINE)));
+    size_t cachedDequeuePos;   // SPSC producer's last seen dequeuePos
+    int activeProducers;       // Enqueue calls between their closed check and publishing, see lf_drained
+    size_t dequeuePos __attribute__((aligned(CB_CACHE_LINE)));
+    size_t cachedEnqueuePos;   // SPSC consumer's last seen enqueuePos
+    int emptyWaiters __attribute__((aligned(CB_CACHE_LINE))); // consumers parked on notEmpty
+    int fullWaiters;           // producers parked on notFull
+    circular_buffer_stats stats __attribute__((aligned(CB_CACHE_LINE))); // Present in every build so the layout does not depend on CB_STATS
 } circular_buffer;
 
 /**
- * Creates and initializes a circular buffer.
- * Returns a pointer to the buffer, or NULL on failure.
+ * Creates and initializes a circular buffer with at least `capacity` slots
+ * (rounded up to a power of two, 0 means BUFFER_SIZE, at most CB_MAX_CAPACITY).
+ * In CB_MODE_POLLING the quitFlag is polled while waiting for items,
+ * in the other modes only circular_buffer_shutdown wakes waiting threads.
+ * The lock-free modes spin briefly and then park on the condition variables.
+ * Returns a pointer to the buffer, or NULL with errno set to EINVAL when
+ * `capacity` exceeds CB_MAX_CAPACITY.
  */
-circular_buffer* circular_buffer_init(bool *quitFlag);
+circular_buffer* circular_buffer_init(bool *quitFlag, circular_buffer_mode mode, size_t capacity);
 
 /**
  * Destroys the circular buffer and frees all associated resources.
+ * With CB_STATS the counters are printed to stderr first.
  */
 void circular_buffer_deinit(circular_buffer *bufferArgs);
 
 /**
  * Enqueues a string into the circular buffer.
  * Blocks if the buffer is full.
+ * Returns false if the buffer has been shut down; the item is not taken.
  */
-void circular_buffer_enqueue(circular_buffer *bufferArgs, char *item);
+bool circular_buffer_enqueue(circular_buffer *bufferArgs, char *item);
 
 /**
  * Dequeues a string from the circular buffer.
  * Blocks if the buffer is empty.
- * Returns a dynamically allocated string (must be freed by the caller).
+ * Returns a dynamically allocated string (must be freed by the caller),
+ * or NULL once the buffer is shut down (or quitFlag is set) and drained.
  */
 char* circular_buffer_dequeue(circular_buffer *bufferArgs);
 
-#endif // CIRCULAR_BUFFER_H
\ No newline at end of file
+/**
+ * Enqueues up to n items, moving as many as fit under one lock (or one CAS)
+ * at a time and blocking while the buffer is full.
+ * Returns the number of items taken, less than n only after a shutdown.
+ */
+size_t circular_buffer_enqueue_many(circular_buffer *bufferArgs, char **items, size_t n);
+
+/**
+ * Dequeues up to n items into `items`, blocking until at least one is available.
+ * Returns the number of items dequeued, or 0 once the buffer is shut down and drained.
+ */
+size_t circular_buffer_dequeue_many(circular_buffer *bufferArgs, char **items, size_t n);
+
+/**
+ * Dequeues up to n items without waiting. Returns 0 when the buffer is empty,
+ * whether or not it is shut down. In spsc mode only the single consumer may call it.
+ */
+size_t circular_buffer_try_dequeue_many(circular_buffer *bufferArgs, char **items, size_t n);
+
+/**
+ * Closes the buffer and wakes every thread blocked in enqueue/dequeue.
+ * Items already in the buffer can still be dequeued.
+ */
+void circular_buffer_shutdown(circular_buffer *bufferArgs);
+
+/**
+ * Returns the number of items in the buffer (a snapshot in lock-free modes).
+ */
+int circular_buffer_count(circular_buffer *bufferArgs);
+
+/**
+ * Copies the instrumentation counters. Returns false (and zeroes `stats`)
+ * when the buffer was built without CB_STATS.
+ */
+bool circular_buffer_get_stats(circular_buffer *bufferArgs, circular_buffer_stats *stats);
+
+/**
+ * Prints the instrumentation counters to `out`, or a note that they are not compiled in.
+ */
+void circular_buffer_print_stats(circular_buffer *bufferArgs, FILE *out);
+
+/**
+ * Parses "polling", "blocking", "spsc" or "mpmc". Returns false on unknown names.
+ */
+bool circular_buffer_parse_mode(const char *name, circular_buffer_mode *mode);
+
+/**
+ * Returns the name of the mode as accepted by circular_buffer_parse_mode.
+ */
+const char* circular_buffer_mode_name(circular_buffer_mode mode);
+
+#endif // CIRCULAR_BUFFER_H
@@ -0,0 +1,394 @@
+#define _GNU_SOURCE
+#include "count_cache.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+
+#define ERR(source) (perror(source), fprintf(stderr, "%s:%d\n", __FILE__, __LINE__), exit(EXIT_FAILURE))
+
+#define FRESH_WINDOW_NS 2000000000LL // pliki zmienione tuż przed startem mogą się jeszcze zmienić w tej samej chwili mtime
+#define INITIAL_LIST 1024
+#define INITIAL_DATA 65536
+#define MAX_ENCODED (10 + LETTER_COUNT * 5) // mapa bitowa i liczniki uint32 jako varinty
+
+#if LETTER_COUNT > 64
+#error "count cache bitmap holds at most 64 letters"
+#endif
+
+static int64_t mtime_ns(const struct stat *st)
+{
+    return (int64_t)st->st_mtim.tv_sec * 1000000000LL + st->st_mtim.tv_nsec;
+}
+
+static int compare_keys(uint64_t devA, uint64_t inoA, uint64_t devB, uint64_t inoB)
+{
+    if(devA != devB)
+        return devA < devB ? -1 : 1;
+    if(inoA != inoB)
+        return inoA < inoB ? -1 : 1;
+    return 0;
+}
+
+static int compare_entries(const void *a, const void *b)
+{
+    const count_cache_entry *x = a, *y = b;
+    return compare_keys(x->dev, x->ino, y->dev, y->ino);
+}
+
+static size_t encode_varint(uint8_t *out, uint64_t value)
+{
+    size_t n = 0;
+    while(value >= 0x80)
+    {
+        out[n++] = (uint8_t)value | 0x80;
+        value >>= 7;
+    }
+    out[n++] = (uint8_t)value;
+    return n;
+}
+
+static bool decode_varint(const uint8_t **p, const uint8_t *end, uint64_t *value)
+{
+    uint64_t v = 0;
+    for(int shift = 0; shift < 64; shift += 7)
+    {
+        if(*p == end)
+            return false;
+        uint8_t byte = *(*p)++;
+        v |= (uint64_t)(byte & 0x7f) << shift;
+        if(!(byte & 0x80))
+        {
+            *value = v;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Mapa bitowa liter, które wystąpiły, i ich liczniki; zerowe liczniki nie zajmują miejsca
+static size_t encode_counts(uint8_t *out, const uint32_t counts[LETTER_COUNT])
+{
+    uint64_t mask = 0;
+    for(int i = 0; i < LETTER_COUNT; i++)
+    {
+        if(counts[i] != 0)
+            mask |= 1ULL << i;
+    }
+    size_t n = encode_varint(out, mask);
+    for(int i = 0; i < LETTER_COUNT; i++)
+    {
+        if(counts[i] != 0)
+            n += encode_varint(out + n, counts[i]);
+    }
+    return n;
+}
+
+// false dla danych wychodzących poza plik lub niepasujących do formatu - taki wpis to chybienie
+static bool decode_counts(const uint8_t *p, const uint8_t *end, uint64_t counts[LETTER_COUNT])
+{
+    uint64_t mask;
+    if(!decode_varint(&p, end, &mask) || (LETTER_COUNT < 64 && mask >> LETTER_COUNT != 0))
+        return false;
+    for(int i = 0; i < LETTER_COUNT; i++)
+    {
+        counts[i] = 0;
+        if((mask >> i & 1) && (!decode_varint(&p, end, &counts[i]) || counts[i] == 0 || counts[i] > UINT32_MAX))
+            return false;
+    }
+    return true;
+}
+
+// Poprawny plik pamięci podręcznej albo NULL - uszkodzony plik oznacza po prostu pustą pamięć
+static bool map_file(count_cache *cache)
+{
+    int fd = open(cache->path, O_RDONLY | O_CLOEXEC);
+    if(fd == -1)
+    {
+        if(errno != ENOENT)
+            perror("count cache open");
+        return false;
+    }
+
+    struct stat st;
+    if(fstat(fd, &st) == -1)
+        ERR("fstat");
+    if((size_t)st.st_size < sizeof(count_cache_header))
+    {
+        close(fd);
+        if(st.st_size > 0)
+            fprintf(stderr, "count cache %s: too short, ignored\n", cache->path);
+        return false;
+    }
+
+    void *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(map == MAP_FAILED)
+        ERR("mmap");
+
+    // przesunięcia w indeksie są sprawdzane dopiero przy dekodowaniu, tu tylko rozmiary sekcji
+    const count_cache_header *header = map;
+    size_t body = st.st_size - sizeof(count_cache_header);
+    if(memcmp(header->magic, COUNT_CACHE_MAGIC, sizeof(COUNT_CACHE_MAGIC)) != 0
+       || header->version != COUNT_CACHE_VERSION || header->letterCount != LETTER_COUNT
+       || header->entryCount > body / sizeof(count_cache_index)
+       || header->dataSize != body - header->entryCount * sizeof(count_cache_index))
+    {
+        fprintf(stderr, "count cache %s: wrong format, ignored\n", cache->path);
+        munmap(map, st.st_size);
+        return false;
+    }
+
+    cache->map = map;
+    cache->mapSize = st.st_size;
+    cache->index = (const count_cache_index *)(header + 1);
+    cache->entryCount = header->entryCount;
+    cache->data = (const uint8_t *)(cache->index + header->entryCount);
+    cache->dataSize = header->dataSize;
+    // wyszukiwanie binarne skacze po pliku - czytanie z wyprzedzeniem nic nie daje
+    madvise(map, st.st_size, MADV_RANDOM);
+    return true;
+}
+
+count_cache* count_cache_open(const char *path, int threadCount)
+{
+    count_cache *cache = calloc(1, sizeof(count_cache));
+    if(cache == NULL)
+        return NULL;
+    cache->path = strdup(path);
+    if(posix_memalign((void **)&cache->lists, CC_CACHE_LINE, sizeof(count_cache_list) * threadCount) != 0
+       || cache->path == NULL)
+    {
+        free(cache->path);
+        free(cache);
+        return NULL;
+    }
+    memset(cache->lists, 0, sizeof(count_cache_list) * threadCount);
+    cache->threadCount = threadCount;
+
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    cache->freshNs = (int64_t)now.tv_sec * 1000000000LL + now.tv_nsec - FRESH_WINDOW_NS;
+
+    map_file(cache);
+    return cache;
+}
+
+bool count_cache_lookup(count_cache *cache, int thread, const struct stat *st, uint64_t counts[LETTER_COUNT])
+{
+    size_t lo = 0, hi = cache->entryCount;
+    while(lo < hi)
+    {
+        size_t mid = lo + (hi - lo) / 2;
+        const count_cache_index *e = &cache->index[mid];
+        int cmp = compare_keys(st->st_dev, st->st_ino, e->dev, e->ino);
+        if(cmp == 0)
+        {
+            if(e->size != (uint64_t)st->st_size || e->mtimeNs != mtime_ns(st))
+                return false; // plik zmieniony od poprzedniego uruchomienia
+            if(e->offset >= cache->dataSize
+               || !decode_counts(cache->data + e->offset, cache->data + cache->dataSize, counts))
+                return false;
+            cache->lists[thread].hits++;
+            return true;
+        }
+        if(cmp < 0)
+            hi = mid;
+        else
+            lo = mid + 1;
+    }
+    return false;
+}
+
+void count_cache_record(count_cache *cache, int thread, const struct stat *st, const uint64_t counts[LETTER_COUNT])
+{
+    if(mtime_ns(st) >= cache->freshNs)
+        return;
+    for(int i = 0; i < LETTER_COUNT; i++)
+    {
+        if(counts[i] > UINT32_MAX)
+            return;
+    }
+
+    count_cache_list *list = &cache->lists[thread];
+    if(list->count == list->capacity)
+    {
+        size_t capacity = list->capacity ? list->capacity * 2 : INITIAL_LIST;
+        count_cache_entry *items = realloc(list->items, capacity * sizeof(count_cache_entry));
+        if(items == NULL)
+            ERR("realloc");
+        list->items = items;
+        list->capacity = capacity;
+    }
+
+    count_cache_entry *e = &list->items[list->count++];
+    e->dev = st->st_dev;
+    e->ino = st->st_ino;
+    e->size = st->st_size;
+    e->mtimeNs = mtime_ns(st);
+    for(int i = 0; i < LETTER_COUNT; i++)
+        e->counts[i] = (uint32_t)counts[i];
+}
+
+void count_cache_stats(const count_cache *cache, uint64_t *hits, uint64_t *recorded)
+{
+    *hits = 0;
+    *recorded = 0;
+    for(int t = 0; t < cache->threadCount; t++)
+    {
+        *hits += cache->lists[t].hits;
+        *recorded += cache->lists[t].count;
+    }
+}
+
+static bool write_all(int fd, const void *data, size_t len)
+{
+    const char *p = data;
+    while(len > 0)
+    {
+        ssize_t written = write(fd, p, len);
+        if(written == -1)
+        {
+            if(errno == EINTR)
+                continue;
+            return false;
+        }
+        p += written;
+        len -= written;
+    }
+    return true;
+}
+
+static bool write_file(count_cache *cache)
+{
+    size_t total = 0;
+    for(int t = 0; t < cache->threadCount; t++)
+        total += cache->lists[t].count;
+
+    // miejsce także na wpisy poprzedniego pliku, dołączane niżej
+    count_cache_entry *all = malloc((total + cache->entryCount) * sizeof(count_cache_entry) + 1);
+    if(all == NULL)
+        ERR("malloc");
+    size_t n = 0;
+    for(int t = 0; t < cache->threadCount; t++)
+    {
+        if(cache->lists[t].count > 0)
+            memcpy(all + n, cache->lists[t].items, cache->lists[t].count * sizeof(count_cache_entry));
+        n += cache->lists[t].count;
+    }
+    qsort(all, n, sizeof(count_cache_entry), compare_entries);
+
+    // twarde dowiązania do tego samego pliku dają powtórzony klucz - zostaje jeden wpis
+    size_t unique = 0;
+    for(size_t i = 0; i < n; i++)
+    {
+        if(unique == 0 || compare_entries(&all[unique - 1], &all[i]) != 0)
+            all[unique++] = all[i];
+    }
+
+    // wpisy z poprzedniego pliku dla plików nieodwiedzonych w tym uruchomieniu (przerwany skan, skan
+    // poddrzewa) zostają; nowy wpis wygrywa z nieaktualnym starym, oba ciągi są posortowane po kluczu
+    size_t kept = 0;
+    for(size_t i = 0, j = 0; i < cache->entryCount; i++)
+    {
+        const count_cache_index *old = &cache->index[i];
+        while(j < unique && compare_keys(all[j].dev, all[j].ino, old->dev, old->ino) < 0)
+            j++;
+        if(j < unique && compare_keys(all[j].dev, all[j].ino, old->dev, old->ino) == 0)
+            continue;
+        uint64_t counts[LETTER_COUNT];
+        if(old->offset >= cache->dataSize
+           || !decode_counts(cache->data + old->offset, cache->data + cache->dataSize, counts))
+            continue; // uszkodzony wpis przepada
+        count_cache_entry *e = &all[unique + kept++];
+        e->dev = old->dev;
+        e->ino = old->ino;
+        e->size = old->size;
+        e->mtimeNs = old->mtimeNs;
+        for(int k = 0; k < LETTER_COUNT; k++)
+            e->counts[k] = (uint32_t)counts[k];
+    }
+    if(kept > 0)
+    {
+        unique += kept;
+        qsort(all, unique, sizeof(count_cache_entry), compare_entries);
+    }
+
+    count_cache_index *index = malloc(unique * sizeof(count_cache_index) + 1);
+    size_t dataCapacity = INITIAL_DATA;
+    uint8_t *data = malloc(dataCapacity);
+    if(index == NULL || data == NULL)
+        ERR("malloc");
+    size_t dataSize = 0;
+    for(size_t i = 0; i < unique; i++)
+    {
+        if(dataCapacity - dataSize < MAX_ENCODED)
+        {
+            dataCapacity *= 2;
+            data = realloc(data, dataCapacity);
+            if(data == NULL)
+                ERR("realloc");
+        }
+        index[i].dev = all[i].dev;
+        index[i].ino = all[i].ino;
+        index[i].size = all[i].size;
+        index[i].mtimeNs = all[i].mtimeNs;
+        index[i].offset = dataSize;
+        dataSize += encode_counts(data + dataSize, all[i].counts);
+    }
+
+    count_cache_header header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, COUNT_CACHE_MAGIC, sizeof(COUNT_CACHE_MAGIC));
+    header.version = COUNT_CACHE_VERSION;
+    header.letterCount = LETTER_COUNT;
+    header.entryCount = unique;
+    header.dataSize = dataSize;
+
+    // nowy plik obok starego i rename - przerwany zapis nie psuje pamięci podręcznej
+    size_t len = strlen(cache->path);
+    char *tmpPath = malloc(len + sizeof(".tmp"));
+    if(tmpPath == NULL)
+        ERR("malloc");
+    memcpy(tmpPath, cache->path, len);
+    memcpy(tmpPath + len, ".tmp", sizeof(".tmp"));
+
+    bool ok = false;
+    int fd = open(tmpPath, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if(fd != -1)
+    {
+        ok = write_all(fd, &header, sizeof(header)) && write_all(fd, index, unique * sizeof(count_cache_index))
+             && write_all(fd, data, dataSize);
+        if(close(fd) == -1)
+            ok = false;
+        if(ok && rename(tmpPath, cache->path) == -1)
+            ok = false;
+        if(!ok)
+            unlink(tmpPath);
+    }
+    if(!ok)
+        perror("count cache write");
+
+    free(tmpPath);
+    free(data);
+    free(index);
+    free(all);
+    return ok;
+}
+
+bool count_cache_close(count_cache *cache)
+{
+    bool ok = write_file(cache);
+    if(cache->map != NULL)
+        munmap(cache->map, cache->mapSize);
+    for(int t = 0; t < cache->threadCount; t++)
+        free(cache->lists[t].items);
+    free(cache->lists);
+    free(cache->path);
+    free(cache);
+    return ok;
+}
@@ -0,0 +1,108 @@
+#ifndef COUNT_CACHE_H
+#define COUNT_CACHE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/stat.h>
+#include "letter_hist.h"
+
+#define COUNT_CACHE_MAGIC "LHCACHE"
+#define COUNT_CACHE_VERSION 2
+#define CC_CACHE_LINE 64
+
+/*
+ * On-disk format, native byte order: a count_cache_header, entryCount
+ * fixed-size index records sorted by (dev, ino) and dataSize bytes of encoded
+ * histograms. The file is mmapped as is and the index is searched with binary
+ * search, so loading does not depend on its size.
+ *
+ * A histogram is a LEB128 varint bitmap of the letters that occur, followed by
+ * one varint count per set bit. Text files use a fraction of the alphabet with
+ * mostly small counts, so a file takes the 40-byte index record plus about
+ * 10-60 bytes instead of 4 bytes for each of the LETTER_COUNT letters.
+ */
+typedef struct count_cache_header {
+    char magic[8];        // COUNT_CACHE_MAGIC
+    uint32_t version;     // COUNT_CACHE_VERSION
+    uint32_t letterCount; // LETTER_COUNT
+    uint64_t entryCount;
+    uint64_t dataSize;
+} count_cache_header;
+
+typedef struct count_cache_index {
+    uint64_t dev;
+    uint64_t ino;
+    uint64_t size;
+    int64_t mtimeNs;
+    uint64_t offset;      // Start of the encoded histogram in the data section
+} count_cache_index;
+
+// A decoded entry, the form recorded in memory during a run
+typedef struct count_cache_entry {
+    uint64_t dev;
+    uint64_t ino;
+    uint64_t size;
+    int64_t mtimeNs;
+    uint32_t counts[LETTER_COUNT];
+} count_cache_entry;
+
+typedef struct count_cache_list {
+    count_cache_entry *items; // Files seen by one thread in this run
+    size_t count;
+    size_t capacity;
+    uint64_t hits;
+} __attribute__((aligned(CC_CACHE_LINE))) count_cache_list;
+
+typedef struct count_cache {
+    char *path;
+    void *map;                      // Previous run's file, read-only
+    size_t mapSize;
+    const count_cache_index *index;
+    uint64_t entryCount;
+    const uint8_t *data;
+    uint64_t dataSize;
+    int64_t freshNs;                // Files modified after this are not stored
+    count_cache_list *lists;        // One per thread, no locking
+    int threadCount;
+} count_cache;
+
+/**
+ * Maps the cache file at `path` if it exists and is valid, otherwise starts
+ * with an empty cache (a damaged file only gets a warning). `threadCount`
+ * threads, numbered from 0, may then look up and record entries concurrently.
+ * Returns NULL on allocation failure.
+ */
+count_cache* count_cache_open(const char *path, int threadCount);
+
+/**
+ * Looks up a file by its stat data. On a hit (same dev, inode, size and
+ * mtime) copies the cached histogram to counts and returns true.
+ * `thread` is the caller's number, used for the hit statistics only.
+ */
+bool count_cache_lookup(count_cache *cache, int thread, const struct stat *st, uint64_t counts[LETTER_COUNT]);
+
+/**
+ * Remembers the histogram of a file for the next run; call it for hits as well,
+ * so the entry is refreshed. Files modified in
+ * the last seconds before count_cache_open and counts above UINT32_MAX are
+ * skipped, since they cannot be trusted or stored.
+ */
+void count_cache_record(count_cache *cache, int thread, const struct stat *st, const uint64_t counts[LETTER_COUNT]);
+
+/**
+ * Number of hits and of entries recorded so far.
+ */
+void count_cache_stats(const count_cache *cache, uint64_t *hits, uint64_t *recorded);
+
+/**
+ * Writes the recorded entries, together with the previous file's entries for
+ * files not recorded in this run (an interrupted scan or a scan of a subtree
+ * keeps the rest of the cache), to a temporary file and renames it over the
+ * cache file, then frees the cache. Entries of deleted files stay until their
+ * inode is reused by a file that gets recorded. Returns false if the file
+ * could not be written.
+ */
+bool count_cache_close(count_cache *cache);
+
+#endif // COUNT_CACHE_H
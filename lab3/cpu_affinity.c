@@ -0,0 +1,207 @@
+#define _GNU_SOURCE
+#include "cpu_affinity.h"
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define NODE_DIR "/sys/devices/system/node"
+
+static const char *mode_names[] = { "none", "rr", "numa" };
+
+static int compare_int(const void *a, const void *b)
+{
+    int x = *(const int *)a, y = *(const int *)b;
+    return (x > y) - (x < y);
+}
+
+// Lista procesorów w formacie sysfs ("0-3,8,10-11") jako zbiór
+static bool read_cpulist(int node, cpu_set_t *set)
+{
+    char path[64], line[4096];
+    snprintf(path, sizeof(path), NODE_DIR "/node%d/cpulist", node);
+    FILE *file = fopen(path, "r");
+    if(file == NULL)
+        return false;
+    bool ok = fgets(line, sizeof(line), file) != NULL;
+    fclose(file);
+    if(!ok)
+        return false;
+
+    CPU_ZERO(set);
+    for(char *save, *range = strtok_r(line, ",\n", &save); range != NULL; range = strtok_r(NULL, ",\n", &save))
+    {
+        int first, last;
+        int fields = sscanf(range, "%d-%d", &first, &last);
+        if(fields < 1)
+            return false;
+        if(fields == 1)
+            last = first;
+        for(int cpu = first; cpu <= last && cpu < CPU_SETSIZE; cpu++)
+            CPU_SET(cpu, set);
+    }
+    return true;
+}
+
+// Numery węzłów z katalogów nodeN, rosnąco; zwraca ich liczbę, 0 bez NUMA w sysfs
+static int read_node_ids(int **ids)
+{
+    *ids = NULL;
+    DIR *dir = opendir(NODE_DIR);
+    if(dir == NULL)
+        return 0;
+    int count = 0, size = 0;
+    struct dirent *entry;
+    while((entry = readdir(dir)) != NULL)
+    {
+        int id;
+        char tail;
+        if(sscanf(entry->d_name, "node%d%c", &id, &tail) != 1)
+            continue;
+        if(count == size)
+        {
+            size = size == 0 ? 8 : 2 * size;
+            int *grown = realloc(*ids, sizeof(int) * size);
+            if(grown == NULL)
+            {
+                closedir(dir);
+                free(*ids);
+                *ids = NULL;
+                return -1;
+            }
+            *ids = grown;
+        }
+        (*ids)[count++] = id;
+    }
+    closedir(dir);
+    qsort(*ids, count, sizeof(int), compare_int);
+    return count;
+}
+
+cpu_topology* cpu_topology_init(void)
+{
+    cpu_set_t allowed;
+    if(sched_getaffinity(0, sizeof(allowed), &allowed) != 0)
+        return NULL;
+    int sysNodes;
+    int *sysIds;
+    if((sysNodes = read_node_ids(&sysIds)) < 0)
+        return NULL;
+
+    cpu_topology *topology = calloc(1, sizeof(cpu_topology));
+    int slots = sysNodes > 0 ? sysNodes : 1;
+    if(topology == NULL || (topology->cpus = malloc(sizeof(int) * CPU_COUNT(&allowed))) == NULL ||
+       (topology->nodeFirst = malloc(sizeof(int) * (slots + 1))) == NULL ||
+       (topology->nodeIds = malloc(sizeof(int) * slots)) == NULL)
+    {
+        free(sysIds);
+        cpu_topology_deinit(topology);
+        return NULL;
+    }
+
+    cpu_set_t assigned;
+    CPU_ZERO(&assigned);
+    for(int i = 0; i < sysNodes; i++)
+    {
+        cpu_set_t nodeCpus;
+        if(!read_cpulist(sysIds[i], &nodeCpus))
+            continue;
+        int first = topology->cpuCount;
+        for(int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+        {
+            if(CPU_ISSET(cpu, &nodeCpus) && CPU_ISSET(cpu, &allowed) && !CPU_ISSET(cpu, &assigned))
+            {
+                CPU_SET(cpu, &assigned);
+                topology->cpus[topology->cpuCount++] = cpu;
+            }
+        }
+        // węzły tylko z pamięcią albo poza maską procesu pomijamy
+        if(topology->cpuCount > first)
+        {
+            topology->nodeFirst[topology->nodeCount] = first;
+            topology->nodeIds[topology->nodeCount++] = sysIds[i];
+        }
+    }
+    free(sysIds);
+
+    // brak informacji o węzłach - wszystkie dozwolone procesory w jednym węźle
+    if(topology->nodeCount == 0 || topology->cpuCount < CPU_COUNT(&allowed))
+    {
+        topology->cpuCount = 0;
+        for(int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+            if(CPU_ISSET(cpu, &allowed))
+                topology->cpus[topology->cpuCount++] = cpu;
+        topology->nodeCount = 1;
+        topology->nodeFirst[0] = 0;
+        topology->nodeIds[0] = 0;
+    }
+    topology->nodeFirst[topology->nodeCount] = topology->cpuCount;
+    return topology;
+}
+
+void cpu_topology_deinit(cpu_topology *topology)
+{
+    if(topology == NULL)
+        return;
+    free(topology->cpus);
+    free(topology->nodeFirst);
+    free(topology->nodeIds);
+    free(topology);
+}
+
+// Węzeł, do którego należy procesor o indeksie `index` w tablicy cpus
+static int node_of_index(const cpu_topology *topology, int index)
+{
+    int node = 0;
+    while(index >= topology->nodeFirst[node + 1])
+        node++;
+    return node;
+}
+
+int cpu_topology_worker_node(const cpu_topology *topology, cpu_affinity_mode mode, int worker)
+{
+    switch(mode)
+    {
+        case CPU_AFFINITY_RR:
+            return node_of_index(topology, worker % topology->cpuCount);
+        case CPU_AFFINITY_NUMA:
+            return worker % topology->nodeCount;
+        case CPU_AFFINITY_NONE:
+        default:
+            return 0;
+    }
+}
+
+bool cpu_topology_worker_set(const cpu_topology *topology, cpu_affinity_mode mode, int worker, cpu_set_t *set)
+{
+    CPU_ZERO(set);
+    if(mode == CPU_AFFINITY_RR)
+        CPU_SET(topology->cpus[worker % topology->cpuCount], set);
+    else if(mode == CPU_AFFINITY_NUMA)
+    {
+        int node = worker % topology->nodeCount;
+        for(int i = topology->nodeFirst[node]; i < topology->nodeFirst[node + 1]; i++)
+            CPU_SET(topology->cpus[i], set);
+    }
+    else
+        return false;
+    return true;
+}
+
+bool cpu_affinity_parse_mode(const char *name, cpu_affinity_mode *mode)
+{
+    for(size_t i = 0; i < sizeof(mode_names) / sizeof(mode_names[0]); i++)
+    {
+        if(strcmp(name, mode_names[i]) == 0)
+        {
+            *mode = (cpu_affinity_mode)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* cpu_affinity_mode_name(cpu_affinity_mode mode)
+{
+    return mode_names[mode];
+}
@@ -0,0 +1,54 @@
+#ifndef CPU_AFFINITY_H
+#define CPU_AFFINITY_H
+
+#include <sched.h> // cpu_set_t - needs _GNU_SOURCE in the including file
+#include <stdbool.h>
+
+typedef enum cpu_affinity_mode {
+    CPU_AFFINITY_NONE, // Threads keep the default attributes and float across all CPUs
+    CPU_AFFINITY_RR,   // Worker i is pinned to the i-th usable CPU, CPUs ordered by NUMA node
+    CPU_AFFINITY_NUMA  // Workers are spread over nodes round-robin, each bound to all CPUs of its node
+} cpu_affinity_mode;
+
+/*
+ * CPUs this process may run on, grouped by NUMA node. Nodes without usable
+ * CPUs (memory-only, or outside the affinity mask) are left out, so node
+ * indices here are dense and need not match the kernel node numbers.
+ */
+typedef struct cpu_topology {
+    int cpuCount;
+    int *cpus;       // Usable CPU numbers, node by node
+    int nodeCount;
+    int *nodeFirst;  // CPUs of node n are cpus[nodeFirst[n]..nodeFirst[n + 1])
+    int *nodeIds;    // Kernel number of each node (nodeN in sysfs)
+} cpu_topology;
+
+/**
+ * Reads the node layout from /sys/devices/system/node and intersects it with
+ * the affinity mask of the calling thread. Without NUMA information in sysfs
+ * all usable CPUs form a single node. Returns NULL on failure.
+ */
+cpu_topology* cpu_topology_init(void);
+
+void cpu_topology_deinit(cpu_topology *topology);
+
+/**
+ * Node index (0..nodeCount-1) that worker `worker` (counted from 0) is placed
+ * on in the given mode; always 0 for CPU_AFFINITY_NONE.
+ */
+int cpu_topology_worker_node(const cpu_topology *topology, cpu_affinity_mode mode, int worker);
+
+/**
+ * Fills `set` with the CPUs worker `worker` should be pinned to. Returns false
+ * for CPU_AFFINITY_NONE, when the thread should keep the default placement.
+ */
+bool cpu_topology_worker_set(const cpu_topology *topology, cpu_affinity_mode mode, int worker, cpu_set_t *set);
+
+/**
+ * Parses "none", "rr" or "numa". Returns false on unknown names.
+ */
+bool cpu_affinity_parse_mode(const char *name, cpu_affinity_mode *mode);
+
+const char* cpu_affinity_mode_name(cpu_affinity_mode mode);
+
+#endif // CPU_AFFINITY_H
@@ -0,0 +1,62 @@
+#include "dir_scan.h"
+#include <dirent.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <linux/limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define ERR(source) (perror(source), fprintf(stderr, "%s:%d\n", __FILE__, __LINE__), exit(EXIT_FAILURE))
+
+void dir_scan_at(int parentFd, const char *name, const char *path, dir_scan_cb cb, void *ctx)
+{
+    int fd = openat(parentFd, name, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd == -1)
+        ERR("openat");
+    DIR *dir = fdopendir(fd);
+    if (!dir)
+        ERR("fdopendir");
+
+    // prefiks "katalog/" kopiujemy raz, nazwy wpisów doklejamy na jego końcu
+    char entryPath[PATH_MAX];
+    size_t prefixLen = strlen(path);
+    if (prefixLen + 2 > PATH_MAX)
+        ERR("Path length exceeds PATH_MAX");
+    memcpy(entryPath, path, prefixLen);
+    entryPath[prefixLen++] = '/';
+
+    struct dirent *entry;
+    struct stat statbuf;
+    while ((entry = readdir(dir)) != NULL)
+    {
+        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0)
+            continue;
+
+        unsigned char type = entry->d_type;
+        if (type == DT_UNKNOWN)
+        {
+            // system plików nie podaje typu - fstatat względem deskryptora katalogu
+            if (fstatat(fd, entry->d_name, &statbuf, AT_SYMLINK_NOFOLLOW) == -1)
+                ERR("fstatat");
+            type = S_ISDIR(statbuf.st_mode) ? DT_DIR : S_ISREG(statbuf.st_mode) ? DT_REG : DT_UNKNOWN;
+        }
+
+        bool isDirectory = type == DT_DIR;
+        if (!isDirectory && !(type == DT_REG && strstr(entry->d_name, ".txt")))
+            continue;
+
+        size_t nameLen = strlen(entry->d_name);
+        if (prefixLen + nameLen >= PATH_MAX)
+            ERR("Path length exceeds PATH_MAX");
+        memcpy(entryPath + prefixLen, entry->d_name, nameLen + 1);
+
+        if (!cb(ctx, fd, entry->d_name, entryPath, isDirectory))
+            break;
+    }
+
+    if (closedir(dir) == -1)
+        ERR("closedir");
+}
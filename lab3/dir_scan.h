@@ -0,0 +1,22 @@
+#ifndef DIR_SCAN_H
+#define DIR_SCAN_H
+
+#include <stdbool.h>
+
+/*
+ * Called for every subdirectory and every regular *.txt file of the scanned
+ * directory. `path` is the full path ("dir/name") and is only valid during
+ * the call; `dirFd` and `name` allow openat/fstatat relative to the directory.
+ * Returning false stops the scan of this directory.
+ */
+typedef bool (*dir_scan_cb)(void *ctx, int dirFd, const char *name, const char *path, bool isDirectory);
+
+/**
+ * Reads one directory level. The directory is opened with openat(parentFd, name),
+ * pass AT_FDCWD and the full path to open it by path. `path` is the prefix used
+ * to build the entries' paths. Entry types come from d_type; fstatat is only
+ * used when the filesystem reports DT_UNKNOWN. Symlinks are skipped, like with lstat.
+ */
+void dir_scan_at(int parentFd, const char *name, const char *path, dir_scan_cb cb, void *ctx);
+
+#endif // DIR_SCAN_H
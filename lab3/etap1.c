@@ -24,7 +24,7 @@ void* consumerFunc(void* voidArgs);
 int main(int argc, char **argv) 
 {
     bool *neededForOtherEtap = NULL;
-    circular_buffer *buffer = circular_buffer_init(neededForOtherEtap);
+    circular_buffer *buffer = circular_buffer_init(neededForOtherEtap, CB_MODE_POLLING, BUFFER_SIZE);
     if(buffer == NULL)
         ERR("Failed to initialize buffer");
 
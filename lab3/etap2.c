@@ -41,7 +41,7 @@ int main(int argc, char **argv)
     if(threadArgs == NULL)
         ERR("malloc");
 
-    circular_buffer *buffer = circular_buffer_init(&quitFlag);
+    circular_buffer *buffer = circular_buffer_init(&quitFlag, CB_MODE_POLLING, BUFFER_SIZE);
 
     int totalFiles = 0;
     int processedFiles = 0;
@@ -168,7 +168,7 @@ void* worker_func(void* voidArgs)
         bool quit = *(args->quitFlag);
         pthread_mutex_unlock(args->mxQuitFlag);
 
-        if (quit && args->buffer->count == 0)
+        if (quit && circular_buffer_count(args->buffer) == 0)
             break;
 
         // Pobranie elementu z bufora
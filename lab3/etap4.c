@@ -1,66 +1,180 @@
+#define _GNU_SOURCE // pthread_attr_setaffinity_np
 #include <linux/limits.h>
 #include <dirent.h>
 #include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
-#include <unistd.h> // do funkcji usleep, read i close
+#include <unistd.h> // getopt
 #include <string.h>
 #include <stdbool.h>
 #include <limits.h> // PATH_MAX
 #include <fcntl.h> // do funkcji open
 #include <sys/stat.h> // do funkcji lstat i sprawdzania typów plików
-#include <ctype.h> // do funkcji isalpha, toupper
 #include <signal.h>
+#include <time.h>
 #include "circular_buffer.h"
+#include "ws_deque.h"
+#include "dir_scan.h"
+#include "letter_hist.h"
+#include "file_io.h"
+#include "file_uring.h"
+#include "letter_stats.h"
+#include "result_writer.h"
+#include "count_cache.h"
+#include "utf8_hist.h"
+#include "cpu_affinity.h"
+#include "path_arena.h"
 
-#define MUTEX_COUNT 52
+#define MAX_BATCH 256 // maksymalna liczba ścieżek przenoszonych jednym wywołaniem *_many
+
+#define STEAL_ROUNDS 2 // ile razy przejść po ofiarach, zanim pracownik zaśnie
 
 #define ERR(source) (perror(source), fprintf(stderr, "%s:%d\n", __FILE__, __LINE__), exit(EXIT_FAILURE))
 
+typedef enum scheduler {
+    SCHED_QUEUE, // wspólny circular_buffer zasilany przez wątek główny
+    SCHED_WS     // work stealing: własna deque Chase-Lev dla każdego pracownika
+} scheduler_t;
+
+typedef struct ws_task {
+    bool isDirectory; // katalog do przeszukania albo plik .txt do zliczenia
+    char path[];
+} ws_task_t;
+
+typedef struct ws_pool {
+    ws_deque *deques;       // deques[i] należy do pracownika o worker_id i+1
+    int count;
+    int *nodes;             // węzeł NUMA każdego pracownika, NULL bez przypięcia (-A)
+    long pending;           // zadania wstawione, a jeszcze niezakończone
+    int idle;               // pracownicy uśpieni na cvIdle
+    bool stopped;           // SIGINT - porzucenie pozostałych zadań
+    pthread_mutex_t mxIdle;
+    pthread_cond_t cvIdle;
+} ws_pool_t;
+
+typedef struct queue_shards {
+    circular_buffer **buffers; // po jednym na węzeł NUMA z pracownikami, 1 bez -A
+    int count;
+    unsigned next;             // shard dla następnej serii producenta (round-robin)
+} queue_shards_t;
+
 typedef struct signal_handler_args {
-    int *alphabetCounter;
-    pthread_mutex_t *mutexes;
+    letter_stats *letters;
     pthread_mutex_t *mxQuitFlag;
     bool *quitFlag;
+    queue_shards_t *queues;
+    ws_pool_t *pool;          // NULL poza trybem work stealing
     pthread_t mainThreadId;
 } signal_handler_args_t;
 
 typedef struct worker_args {
     pthread_t tid;
-    circular_buffer *buffer;
-    bool *quitFlag;
-    pthread_mutex_t *mxQuitFlag;
+    circular_buffer *buffer;  // shard węzła pracownika
+    queue_shards_t *queues;   // pozostałe shardy - kradzież, gdy własny jest pusty
+    int node;                 // węzeł NUMA pracownika (indeks sharda), 0 bez -A
     int worker_id;
-    int *processedFiles; // liczba przetworzonych plików txt
-    int *totalFiles;     // całkowita liczba plików
-    pthread_mutex_t *mxProcessed;
-    int *alphabetCounter;
-    pthread_mutex_t *mutexes; // tablica mutexów dla każdego znaku
-    pthread_mutex_t *mxPrint; // mutex do synchronizacji wypisywania
+    letter_stats *letters;    // globalne liczniki liter
+    result_writer *writer;    // wątek wypisujący wyniki poszczególnych plików
+    size_t batchSize;         // ile ścieżek pobierać naraz z bufora
+    ws_pool_t *pool;
+    unsigned int seed;        // losowanie ofiar kradzieży
+    file_io_mode ioMode;
+    unsigned ioDepth;         // pliki w locie w trybie uring
+    file_uring *ring;         // pierścień io_uring pracownika, NULL poza trybem uring
+    file_io_stats ioStats;    // statystyki odczytu tego pracownika, sumowane po zakończeniu
+    count_cache *cache;       // histogramy z poprzednich uruchomień, NULL bez -C
+    utf8_hist *hist;          // liczniki znaków UTF-8 tego pracownika, NULL bez -a
 } worker_args_t;
 
-void ReadArgs(int argc, char **argv, char *startPath, int *threadCount);
-void explore_directory(const char* dir_path, circular_buffer *buffer, int *totalFiles);
+typedef struct uring_batch {
+    worker_args_t *args;
+    struct stat st[MAX_BATCH]; // stat plików czytanych przez pierścień, do zapisu w pamięci podręcznej
+} uring_batch_t;
+
+typedef struct path_batch {
+    char *items[MAX_BATCH]; // ścieżki zebrane w jednym przejściu readdir
+    size_t count;
+    size_t size;            // docelowy rozmiar serii
+    bool closed;            // bufor zamknięty - kolejne ścieżki są odrzucane
+} path_batch_t;
+
+typedef struct dir_job {
+    struct dir_job *next;
+    char path[];
+} dir_job_t;
+
+typedef struct scanner_pool {
+    dir_job_t *jobs;        // stos katalogów czekających na przeszukanie
+    int pending;            // katalogi na stosie lub w trakcie przeszukiwania
+    bool stopped;           // bufor zamknięty (SIGINT) - porzucenie reszty drzewa
+    pthread_mutex_t mxJobs;
+    pthread_cond_t cvJobs;
+} scanner_pool_t;
+
+typedef struct scan_ctx {
+    pthread_t tid;
+    queue_shards_t *queues;
+    path_arena *arena;      // ścieżki plików tego skanera, zwalniane przez pracowników
+    path_batch_t batch;
+    int totalFiles;         // pliki przekazane do bufora przez ten skaner
+    scanner_pool_t *pool;   // NULL - podkatalogi przeszukiwane rekurencyjnie w tym wątku
+} scan_ctx_t;
+
+typedef struct program_options {
+    char startPath[PATH_MAX];
+    int threadCount;
+    scheduler_t scheduler;
+    circular_buffer_mode queueMode;
+    size_t queueCapacity;  // zaokrąglana w górę do potęgi dwójki
+    size_t batchSize;      // 1 = pojedyncze enqueue/dequeue
+    int scannerCount;      // 0 = skanowanie w wątku głównym
+    file_io_mode ioMode;
+    unsigned ioDepth;
+    letter_stats_mode countersMode;
+    result_verbosity verbosity;
+    const char *cachePath; // NULL - bez pamięci podręcznej histogramów
+    const char *alphabet;  // litery zliczane jako UTF-8, NULL - tylko ASCII
+    cpu_affinity_mode affinity;
+} program_options_t;
+
+void ReadArgs(int argc, char **argv, program_options_t *options);
+void usage(const char *name);
+void explore_directory(scan_ctx_t *ctx, int parentFd, const char *name, const char *path);
+bool explore_entry(void *voidCtx, int dirFd, const char *name, const char *path, bool isDirectory);
+void flush_batch(queue_shards_t *queues, path_batch_t *batch, int *totalFiles);
+int explore_parallel(const char *startPath, queue_shards_t *queues, int scannerCount, size_t batchSize, path_arena **arenas);
+void* scanner_func(void *voidArgs);
+queue_shards_t* queue_shards_init(bool *quitFlag, const program_options_t *options, int count);
+void queue_shards_shutdown(queue_shards_t *queues);
+void queue_shards_deinit(queue_shards_t *queues);
+size_t worker_dequeue(worker_args_t *args, char **files, size_t n);
 void* worker_func(void* voidArgs);
-void process_file(const char* file_path, int *alphabetCounter, pthread_mutex_t *mutexes, int worker_id, pthread_mutex_t *mxPrint);
+ws_pool_t* ws_pool_init(int count, const char *startPath, const int *nodes);
+void ws_pool_deinit(ws_pool_t *pool);
+void ws_pool_push(ws_pool_t *pool, int self, const char *path, bool isDirectory);
+void ws_pool_stop(ws_pool_t *pool);
+void* ws_worker_func(void* voidArgs);
+bool ws_explore_entry(void *voidArgs, int dirFd, const char *name, const char *path, bool isDirectory);
+void process_file(const char* file_path, worker_args_t *args);
+void process_uring_batch(char **paths, size_t n, worker_args_t *args);
+void merge_counts(const char* file_path, const uint64_t *localCounter, uint64_t bytes, worker_args_t *args);
+void uring_file_done(void *voidBatch, size_t index, const char *path, const uint64_t counts[LETTER_COUNT], uint64_t bytes);
+void uring_setup(worker_args_t *args);
 void* signal_handler_thread(void* voidArgs);
-void print_alphabet_counters(int *alphabetCounter, pthread_mutex_t *mutexes);
+void print_alphabet_counters(const uint64_t *alphabetCounter);
+void print_utf8_counters(const utf8_hist *hist);
+void print_progress(letter_stats *letters);
 
 int main(int argc, char **argv) 
 {
-    int threadCount;
-    char startPath[20];
-    int alphabetCounter[52] = {0};
-    pthread_mutex_t mutexes[MUTEX_COUNT];
-    pthread_mutex_t mxPrint = PTHREAD_MUTEX_INITIALIZER;
+    program_options_t options;
 
-    for(int i = 0; i < MUTEX_COUNT; i++)
-    {
-        if(pthread_mutex_init(&mutexes[i], NULL) != 0)
-            ERR("Setup of letter mutexes");
-    }
-    
-    ReadArgs(argc, argv, startPath, &threadCount);
+    ReadArgs(argc, argv, &options);
+    int threadCount = options.threadCount;
+
+    letter_stats *letters = letter_stats_init(options.countersMode, threadCount);
+    if(letters == NULL)
+        ERR("letter_stats_init");
 
     bool quitFlag = false;
     pthread_mutex_t mxQuitFlag = PTHREAD_MUTEX_INITIALIZER;
@@ -69,20 +183,75 @@ int main(int argc, char **argv)
     if(threadArgs == NULL)
         ERR("malloc");
 
-    circular_buffer *buffer = circular_buffer_init(&quitFlag);
+    // węzeł NUMA każdego pracownika; bez -A wszyscy w węźle 0
+    cpu_topology *topology = NULL;
+    int *workerNodes = calloc(threadCount, sizeof(int));
+    if(workerNodes == NULL)
+        ERR("calloc");
+    int nodeCount = 1;
+    if(options.affinity != CPU_AFFINITY_NONE)
+    {
+        if((topology = cpu_topology_init()) == NULL)
+            ERR("cpu_topology_init");
+        for(int i = 0; i < threadCount; i++)
+        {
+            workerNodes[i] = cpu_topology_worker_node(topology, options.affinity, i);
+            if(workerNodes[i] + 1 > nodeCount)
+                nodeCount = workerNodes[i] + 1;
+        }
+    }
+
+    // w trybie work stealing katalog startowy jest pierwszym zadaniem
+    ws_pool_t *pool = NULL;
+    if(options.scheduler == SCHED_WS)
+        pool = ws_pool_init(threadCount, options.startPath, topology != NULL ? workerNodes : NULL);
 
-    int totalFiles = 0;
-    int processedFiles = 0;
-    pthread_mutex_t mxProcessed = PTHREAD_MUTEX_INITIALIZER;
+    // shard kolejki na każdy węzeł z pracownikami
+    queue_shards_t *queues = queue_shards_init(&quitFlag, &options, pool == NULL ? nodeCount : 1);
+    if(topology != NULL)
+        printf("Przypięcie %s: %d węzłów NUMA, %d procesorów, pracownicy w %d węzłach\n",
+               cpu_affinity_mode_name(options.affinity), topology->nodeCount, topology->cpuCount, nodeCount);
 
     signal_handler_args_t signalArgs = {
-        .alphabetCounter = alphabetCounter,
-        .mutexes = mutexes,
+        .letters = letters,
         .mxQuitFlag = &mxQuitFlag,
         .quitFlag = &quitFlag,
+        .queues = queues,
+        .pool = pool,
         .mainThreadId = pthread_self()
     };
 
+    // SIGUSR1 i SIGINT odbiera tylko sigwait w wątku obsługi sygnałów - maska dziedziczona przez wszystkie wątki
+    sigset_t signalMask;
+    sigemptyset(&signalMask);
+    sigaddset(&signalMask, SIGUSR1);
+    sigaddset(&signalMask, SIGINT);
+    if(pthread_sigmask(SIG_BLOCK, &signalMask, NULL) != 0)
+        ERR("pthread_sigmask");
+
+    result_writer *writer = result_writer_init(STDOUT_FILENO, options.verbosity, letters);
+    if(writer == NULL)
+        ERR("result_writer_init");
+
+    count_cache *cache = NULL;
+    if(options.cachePath != NULL && (cache = count_cache_open(options.cachePath, threadCount)) == NULL)
+        ERR("count_cache_open");
+
+    utf8_alphabet *alphabet = NULL;
+    utf8_hist *hists = NULL;
+    if(options.alphabet != NULL)
+    {
+        if((alphabet = utf8_alphabet_init(options.alphabet)) == NULL)
+            ERR("Invalid alphabet");
+        if((hists = malloc(sizeof(utf8_hist) * threadCount)) == NULL)
+            ERR("malloc");
+        for(int i = 0; i < threadCount; i++)
+        {
+            if(!utf8_hist_init(&hists[i], alphabet))
+                ERR("utf8_hist_init");
+        }
+    }
+
     pthread_t signalThread;
     if(pthread_create(&signalThread, NULL, signal_handler_thread, &signalArgs) != 0)
         ERR("Cannot create signal handler thread");
@@ -90,207 +259,770 @@ int main(int argc, char **argv)
     // Przypisanie argumentów wątków pomocniczych
     for(int i = 0; i < threadCount; i++)
     {
-        threadArgs[i].buffer = buffer;
+        threadArgs[i].node = workerNodes[i];
+        threadArgs[i].buffer = queues->buffers[pool == NULL ? workerNodes[i] : 0];
+        threadArgs[i].queues = queues;
         threadArgs[i].worker_id = i+1;
-        threadArgs[i].quitFlag = &quitFlag;
-        threadArgs[i].processedFiles = &processedFiles;
-        threadArgs[i].totalFiles = &totalFiles;
-        threadArgs[i].mxQuitFlag = &mxQuitFlag;
-        threadArgs[i].mxProcessed = &mxProcessed;
-        threadArgs[i].alphabetCounter = alphabetCounter;
-        threadArgs[i].mutexes = mutexes;
-        threadArgs[i].mxPrint = &mxPrint;
+        threadArgs[i].letters = letters;
+        threadArgs[i].writer = writer;
+        threadArgs[i].batchSize = options.batchSize;
+        threadArgs[i].pool = pool;
+        threadArgs[i].seed = (unsigned int)(i + 1) * 2654435761u;
+        threadArgs[i].ioMode = options.ioMode;
+        threadArgs[i].ioDepth = options.ioDepth;
+        memset(&threadArgs[i].ioStats, 0, sizeof(file_io_stats));
+        threadArgs[i].cache = cache;
+        threadArgs[i].hist = hists != NULL ? &hists[i] : NULL;
     }
 
+    struct timespec startTime, endTime;
+    clock_gettime(CLOCK_MONOTONIC, &startTime);
+
     for(int i = 0; i < threadCount; i++)
     {
-        if(pthread_create(&threadArgs[i].tid, NULL, worker_func, &threadArgs[i]) != 0)
+        // z -A pracownik startuje już na swoich procesorach, zanim dotknie pamięci
+        pthread_attr_t attr;
+        cpu_set_t cpus;
+        if(pthread_attr_init(&attr) != 0)
+            ERR("pthread_attr_init");
+        if(topology != NULL && cpu_topology_worker_set(topology, options.affinity, i, &cpus) &&
+           pthread_attr_setaffinity_np(&attr, sizeof(cpus), &cpus) != 0)
+            ERR("pthread_attr_setaffinity_np");
+        if(pthread_create(&threadArgs[i].tid, &attr, pool != NULL ? ws_worker_func : worker_func, &threadArgs[i]) != 0)
             ERR("Cannot create a thread");
+        pthread_attr_destroy(&attr);
     }
 
-    explore_directory(startPath, buffer, &totalFiles);
-
-    // Czekaj, aż wszystkie pliki zostaną przetworzone
-    while (true) {
-        pthread_mutex_lock(&mxProcessed);
-        if (processedFiles == totalFiles) {
-            pthread_mutex_unlock(&mxProcessed);
-            break;
-        }
-        pthread_mutex_unlock(&mxProcessed);
-        usleep(100000); // Czekanie na przetworzenie plików (0.1s)
+    // Pracownicy work stealing sami przeszukują katalogi i kończą, gdy nie ma już zadań;
+    // w trybie kolejki każdy skaner ma własną arenę ścieżek, żyjącą do końca pracowników
+    int arenaCount = pool != NULL ? 0 : options.scannerCount > 0 ? options.scannerCount : 1;
+    path_arena **arenas = malloc(sizeof(path_arena *) * (arenaCount > 0 ? arenaCount : 1));
+    if(arenas == NULL)
+        ERR("malloc");
+    for(int i = 0; i < arenaCount; i++)
+    {
+        if((arenas[i] = path_arena_init()) == NULL)
+            ERR("path_arena_init");
     }
+    if(pool == NULL)
+    {
+        if(options.scannerCount > 0)
+            explore_parallel(options.startPath, queues, options.scannerCount, options.batchSize, arenas);
+        else
+        {
+            scan_ctx_t ctx = { .queues = queues, .arena = arenas[0], .batch = { .count = 0, .size = options.batchSize, .closed = false },
+                               .totalFiles = 0, .pool = NULL };
+            explore_directory(&ctx, AT_FDCWD, options.startPath, options.startPath);
+        }
 
-    // Ustawienie flagi zakończenia pracy
-    pthread_mutex_lock(&mxQuitFlag);
-    quitFlag = true;
-    pthread_mutex_unlock(&mxQuitFlag);
+        // Koniec skanowania - pracownicy opróżniają bufor i kończą, gdy dequeue zwróci 0
+        queue_shards_shutdown(queues);
+    }
 
     for(int i = 0; i < threadCount; i++)
     {
         if(pthread_join(threadArgs[i].tid, NULL) != 0)
             ERR("pthread join");
     }
+    clock_gettime(CLOCK_MONOTONIC, &endTime);
+    result_writer_deinit(writer); // dopisanie zaległych wyników przed podsumowaniem
+    // po SIGINT w buforach mogą zostać niepobrane ścieżki - znikają razem z arenami
+    for(int i = 0; i < arenaCount; i++)
+        path_arena_deinit(arenas[i]);
+    free(arenas);
 
-    // Zwolnienie zasobów
-    for(int i = 0; i < MUTEX_COUNT; i++)
+    print_progress(letters);
+
+    // Podsumowanie przepustowości odczytu
+    file_io_stats ioStats = {0};
+    for(int i = 0; i < threadCount; i++)
+        file_io_stats_add(&ioStats, &threadArgs[i].ioStats);
+    file_io_stats_print(&ioStats, options.ioMode,
+                        (endTime.tv_sec - startTime.tv_sec) + (endTime.tv_nsec - startTime.tv_nsec) / 1e9);
+
+    if(cache != NULL)
+    {
+        uint64_t hits, recorded;
+        count_cache_stats(cache, &hits, &recorded);
+        printf("Pamięć podręczna: %lu plików bez odczytu, %lu wpisów zapisanych\n",
+               (unsigned long)hits, (unsigned long)recorded);
+        count_cache_close(cache);
+    }
+
+    if(hists != NULL)
     {
-        if(pthread_mutex_destroy(&mutexes[i]) != 0)
-            ERR("Mutex destroy");
+        for(int i = 1; i < threadCount; i++)
+            utf8_hist_add(&hists[0], &hists[i]);
+        print_utf8_counters(&hists[0]);
+        for(int i = 0; i < threadCount; i++)
+            utf8_hist_deinit(&hists[i]);
+        free(hists);
+        utf8_alphabet_deinit(alphabet);
     }
 
-    pthread_mutex_destroy(&mxPrint);
-    circular_buffer_deinit(buffer);
+    // Zwolnienie zasobów
+    letter_stats_deinit(letters);
+    queue_shards_deinit(queues);
+    ws_pool_deinit(pool);
+    cpu_topology_deinit(topology);
+    free(workerNodes);
     pthread_mutex_destroy(&mxQuitFlag);
-    pthread_mutex_destroy(&mxProcessed);
     free(threadArgs);
 
     return EXIT_SUCCESS;
 }
 
-void ReadArgs(int argc, char** argv, char *startPath, int *threadCount)
+void usage(const char *name)
 {
-    if(argc != 3)
-        ERR("Invalid number of arguments");
+    fprintf(stderr, "Usage: %s [-b capacity] [-n batch] [-s scanners] [-i read|mmap|uring] [-d depth] [-c mutex|atomic|local] [-v 0|1|2] [-C cache] [-a pl|ascii|letters] [-A none|rr|numa] directory threads [polling|blocking|spsc|mpmc|ws]\n", name);
+    exit(EXIT_FAILURE);
+}
 
-    strncpy(startPath, argv[1], strlen(argv[1])+1);
-    startPath[PATH_MAX-1] = '\0';
+void ReadArgs(int argc, char** argv, program_options_t *options)
+{
+    options->scheduler = SCHED_QUEUE;
+    options->queueMode = CB_MODE_BLOCKING;
+    options->queueCapacity = BUFFER_SIZE;
+    options->batchSize = 1;
+    options->scannerCount = 0;
+    options->ioMode = FILE_IO_READ;
+    options->ioDepth = FILE_URING_DEFAULT_DEPTH;
+    options->countersMode = LETTER_STATS_LOCAL;
+    options->verbosity = RW_TABLES;
+    options->cachePath = NULL;
+    options->alphabet = NULL;
+    options->affinity = CPU_AFFINITY_NONE;
 
-    *threadCount = atoi(argv[2]);
-    if(*threadCount < 1)
+    int c;
+    while((c = getopt(argc, argv, "b:n:s:i:d:c:v:C:a:A:")) != -1)
+    {
+        switch(c)
+        {
+            case 'b':
+                options->queueCapacity = strtoul(optarg, NULL, 10);
+                if(options->queueCapacity < 1 || options->queueCapacity > CB_MAX_CAPACITY)
+                    ERR("Invalid queue capacity");
+                break;
+            case 'n':
+                options->batchSize = strtoul(optarg, NULL, 10);
+                if(options->batchSize < 1 || options->batchSize > MAX_BATCH)
+                    ERR("Invalid batch size");
+                break;
+            case 's':
+                options->scannerCount = atoi(optarg);
+                if(options->scannerCount < 0)
+                    ERR("Invalid scanner count");
+                break;
+            case 'i':
+                if(!file_io_parse_mode(optarg, &options->ioMode))
+                    ERR("Invalid I/O mode");
+                break;
+            case 'd':
+                options->ioDepth = strtoul(optarg, NULL, 10);
+                if(options->ioDepth < 1 || options->ioDepth > MAX_BATCH)
+                    ERR("Invalid io_uring queue depth");
+                break;
+            case 'c':
+                if(!letter_stats_parse_mode(optarg, &options->countersMode))
+                    ERR("Invalid counters mode");
+                break;
+            case 'v':
+                // 0 - bez wyników plików, 1 - linia na plik, 2 - linie i tabela liter
+                options->verbosity = (result_verbosity)atoi(optarg);
+                if(options->verbosity < RW_QUIET || options->verbosity > RW_TABLES)
+                    ERR("Invalid verbosity");
+                break;
+            case 'C':
+                options->cachePath = optarg;
+                break;
+            case 'a':
+                // pl i ascii to gotowe alfabety, inny napis to lista liter w UTF-8
+                if(strcmp(optarg, "pl") == 0)
+                    options->alphabet = UTF8_ALPHABET_POLISH;
+                else if(strcmp(optarg, "ascii") == 0)
+                    options->alphabet = UTF8_ALPHABET_ASCII;
+                else
+                    options->alphabet = optarg;
+                break;
+            case 'A':
+                // rr - kolejne procesory, numa - kolejne węzły; kolejka dzielona na shardy węzłów
+                if(!cpu_affinity_parse_mode(optarg, &options->affinity))
+                    ERR("Invalid affinity mode");
+                break;
+            default:
+                usage(argv[0]);
+        }
+    }
+
+    if(argc - optind != 2 && argc - optind != 3)
+        usage(argv[0]);
+
+    strncpy(options->startPath, argv[optind], PATH_MAX-1);
+    options->startPath[PATH_MAX-1] = '\0';
+
+    options->threadCount = atoi(argv[optind + 1]);
+    if(options->threadCount < 1)
         ERR("Invalid thread count");
+
+    // opcjonalny rodzaj kolejki: polling, blocking, spsc, mpmc lub ws (work stealing)
+    if(argc - optind == 3)
+    {
+        if(strcmp(argv[optind + 2], "ws") == 0)
+            options->scheduler = SCHED_WS;
+        else if(!circular_buffer_parse_mode(argv[optind + 2], &options->queueMode))
+            ERR("Invalid queue mode");
+    }
+    // w spsc enqueuePos zapisuje bez synchronizacji tylko jeden producent - jeden skaner i jeden pracownik
+    if(options->queueMode == CB_MODE_SPSC && (options->threadCount != 1 || options->scannerCount > 1))
+        ERR("spsc queue requires exactly one worker thread and at most one scanner");
+    // w ws katalogi przeszukują sami pracownicy, osobnych skanerów nie ma
+    if(options->scheduler == SCHED_WS && options->scannerCount > 0)
+        ERR("-s cannot be combined with ws");
+    // pamięć podręczna przechowuje tylko 52 liczniki ASCII
+    if(options->alphabet != NULL && options->cachePath != NULL)
+        ERR("-C cannot be combined with -a");
 }
 
-void explore_directory(const char* dir_path, circular_buffer *buffer, int *totalFiles)
+// Przekazuje zebrane ścieżki do kolejnego sharda; po zamknięciu bufora zwalnia resztę
+void flush_batch(queue_shards_t *queues, path_batch_t *batch, int *totalFiles)
 {
-    DIR *dir = opendir(dir_path);
-    if (!dir)
-        ERR("opendir");
+    circular_buffer *buffer = queues->buffers[0];
+    if(queues->count > 1)
+        buffer = queues->buffers[__atomic_fetch_add(&queues->next, 1, __ATOMIC_RELAXED) % queues->count];
+    size_t done = batch->closed ? 0 : circular_buffer_enqueue_many(buffer, batch->items, batch->count);
+    if(done < batch->count)
+        batch->closed = true; // bufor zamknięty (SIGINT)
+    for(size_t i = done; i < batch->count; i++)
+        path_arena_release(batch->items[i]);
+    *totalFiles += done;
+    batch->count = 0;
+}
 
-    struct dirent *entry;
-    struct stat statbuf;
-    char path[PATH_MAX];
+void explore_directory(scan_ctx_t *ctx, int parentFd, const char *name, const char *path)
+{
+    dir_scan_at(parentFd, name, path, explore_entry, ctx);
 
-    while ((entry = readdir(dir)) != NULL)
-    {
-        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0)
-            continue;
+    // koniec przejścia readdir - oddajemy zebraną serię pracownikom
+    if (ctx->batch.count > 0)
+        flush_batch(ctx->queues, &ctx->batch, &ctx->totalFiles);
+}
 
-        // Zbudowanie pełnej ścieżki do pliku/katalogu
-        if (snprintf(path, PATH_MAX, "%s/%s", dir_path, entry->d_name) >= PATH_MAX)
+bool explore_entry(void *voidCtx, int dirFd, const char *name, const char *path, bool isDirectory)
+{
+    scan_ctx_t *ctx = voidCtx;
+    if (isDirectory)
+    {
+        if (ctx->pool == NULL)
+            explore_directory(ctx, dirFd, name, path); // rekurencja względem deskryptora katalogu
+        else
         {
-            ERR("Path length exceeds PATH_MAX");
-        }
+            // w trybie równoległym podkatalog staje się zadaniem dla puli skanerów
+            size_t len = strlen(path);
+            dir_job_t *job = malloc(sizeof(dir_job_t) + len + 1);
+            if (job == NULL)
+                ERR("malloc");
+            memcpy(job->path, path, len + 1);
 
-        // Sprawdzenie typu pliku za pomocą lstat
-        if (lstat(path, &statbuf) == -1)
-        {
-            ERR("lstat");
+            pthread_mutex_lock(&ctx->pool->mxJobs);
+            job->next = ctx->pool->jobs;
+            ctx->pool->jobs = job;
+            ctx->pool->pending++;
+            pthread_cond_signal(&ctx->pool->cvJobs);
+            pthread_mutex_unlock(&ctx->pool->mxJobs);
         }
+    }
+    else
+    {
+        // Plik regularny z rozszerzeniem .txt
+        char *copy = path_arena_strdup(ctx->arena, path);
+        if (copy == NULL)
+            ERR("path_arena_strdup");
+        ctx->batch.items[ctx->batch.count++] = copy;
+        if (ctx->batch.count == ctx->batch.size)
+            flush_batch(ctx->queues, &ctx->batch, &ctx->totalFiles);
+    }
+    return !ctx->batch.closed;
+}
 
-        if (S_ISDIR(statbuf.st_mode))
-        {
-            // Rekurencyjne przeszukiwanie podkatalogów
-            explore_directory(path, buffer, totalFiles);
-        }
-        else if (S_ISREG(statbuf.st_mode) && strstr(entry->d_name, ".txt"))
-        {
-            // Plik regularny z rozszerzeniem .txt
-            circular_buffer_enqueue(buffer, strdup(path));
-            (*totalFiles)++;
-        }
+// Przeszukuje drzewo pulą skanerów; zwraca liczbę plików przekazanych do bufora
+int explore_parallel(const char *startPath, queue_shards_t *queues, int scannerCount, size_t batchSize, path_arena **arenas)
+{
+    scanner_pool_t pool = { .jobs = NULL, .pending = 0, .stopped = false };
+    if (pthread_mutex_init(&pool.mxJobs, NULL) != 0)
+        ERR("pthread_mutex_init");
+    if (pthread_cond_init(&pool.cvJobs, NULL) != 0)
+        ERR("pthread_cond_init");
+
+    size_t len = strlen(startPath);
+    dir_job_t *root = malloc(sizeof(dir_job_t) + len + 1);
+    if (root == NULL)
+        ERR("malloc");
+    memcpy(root->path, startPath, len + 1);
+    root->next = NULL;
+    pool.jobs = root;
+    pool.pending = 1;
+
+    scan_ctx_t *scanners = malloc(sizeof(scan_ctx_t) * scannerCount);
+    if (scanners == NULL)
+        ERR("malloc");
+    for (int i = 0; i < scannerCount; i++)
+    {
+        scanners[i].queues = queues;
+        scanners[i].arena = arenas[i];
+        scanners[i].batch.count = 0;
+        scanners[i].batch.size = batchSize;
+        scanners[i].batch.closed = false;
+        scanners[i].totalFiles = 0;
+        scanners[i].pool = &pool;
+        if (pthread_create(&scanners[i].tid, NULL, scanner_func, &scanners[i]) != 0)
+            ERR("Cannot create scanner thread");
+    }
+
+    int totalFiles = 0;
+    for (int i = 0; i < scannerCount; i++)
+    {
+        if (pthread_join(scanners[i].tid, NULL) != 0)
+            ERR("pthread join");
+        totalFiles += scanners[i].totalFiles;
     }
 
-    if (closedir(dir) == -1)
-        ERR("closedir");
+    // po zatrzymaniu na stosie mogą zostać nieprzeszukane katalogi
+    while (pool.jobs != NULL)
+    {
+        dir_job_t *next = pool.jobs->next;
+        free(pool.jobs);
+        pool.jobs = next;
+    }
+    free(scanners);
+    pthread_cond_destroy(&pool.cvJobs);
+    pthread_mutex_destroy(&pool.mxJobs);
+    return totalFiles;
+}
+
+void* scanner_func(void *voidArgs)
+{
+    scan_ctx_t *ctx = voidArgs;
+    scanner_pool_t *pool = ctx->pool;
+
+    pthread_mutex_lock(&pool->mxJobs);
+    for (;;)
+    {
+        while (pool->jobs == NULL && pool->pending > 0 && !pool->stopped)
+            pthread_cond_wait(&pool->cvJobs, &pool->mxJobs);
+        if (pool->jobs == NULL || pool->stopped)
+            break;
+
+        dir_job_t *job = pool->jobs;
+        pool->jobs = job->next;
+        pthread_mutex_unlock(&pool->mxJobs);
+
+        explore_directory(ctx, AT_FDCWD, job->path, job->path);
+        free(job);
+
+        pthread_mutex_lock(&pool->mxJobs);
+        if (ctx->batch.closed)
+            pool->stopped = true;
+        // ostatni katalog albo zatrzymanie - budzimy pozostałe skanery, żeby zakończyły pracę
+        if (--pool->pending == 0 || pool->stopped)
+            pthread_cond_broadcast(&pool->cvJobs);
+    }
+    pthread_mutex_unlock(&pool->mxJobs);
+    return NULL;
+}
+
+queue_shards_t* queue_shards_init(bool *quitFlag, const program_options_t *options, int count)
+{
+    queue_shards_t *queues = malloc(sizeof(queue_shards_t));
+    if(queues == NULL || (queues->buffers = malloc(sizeof(circular_buffer *) * count)) == NULL)
+        ERR("malloc");
+    for(int i = 0; i < count; i++)
+        queues->buffers[i] = circular_buffer_init(quitFlag, options->queueMode, options->queueCapacity);
+    queues->count = count;
+    queues->next = 0;
+    return queues;
+}
+
+void queue_shards_shutdown(queue_shards_t *queues)
+{
+    for(int i = 0; i < queues->count; i++)
+        circular_buffer_shutdown(queues->buffers[i]);
+}
+
+void queue_shards_deinit(queue_shards_t *queues)
+{
+    for(int i = 0; i < queues->count; i++)
+        circular_buffer_deinit(queues->buffers[i]);
+    free(queues->buffers);
+    free(queues);
+}
+
+// Kradzież z cudzych shardów, zaczynając od następnego; 0, gdy wszystkie są puste
+static size_t steal_from_shards(worker_args_t *args, char **files, size_t n)
+{
+    queue_shards_t *queues = args->queues;
+    for(int i = 1; i < queues->count; i++)
+    {
+        size_t k = circular_buffer_try_dequeue_many(queues->buffers[(args->node + i) % queues->count], files, n);
+        if(k > 0)
+            return k;
+    }
+    return 0;
+}
+
+// Najpierw własny shard, cudze tylko gdy własny jest pusty; 0 - wszystkie zamknięte i puste
+size_t worker_dequeue(worker_args_t *args, char **files, size_t n)
+{
+    if(args->queues->count == 1)
+        return circular_buffer_dequeue_many(args->buffer, files, n);
+
+    size_t k;
+    if((k = circular_buffer_try_dequeue_many(args->buffer, files, n)) > 0 ||
+       (k = steal_from_shards(args, files, n)) > 0)
+        return k;
+    // wszystko puste - czekamy na własnym shardzie, producenci zasilają go na zmianę z pozostałymi
+    if((k = circular_buffer_dequeue_many(args->buffer, files, n)) > 0)
+        return k;
+    // własny zamknięty i pusty - pozostałe zamknięto razem z nim, zabieramy z nich resztę
+    return steal_from_shards(args, files, n);
 }
 
 void* worker_func(void* voidArgs)
 {
     worker_args_t* args = voidArgs;
-    char* file_path;
+    char* files[MAX_BATCH];
+
+    uring_setup(args);
+    // w trybie uring seria z bufora wypełnia całą kolejkę pierścienia
+    size_t batchSize = args->ring != NULL ? args->ioDepth : args->batchSize;
 
-    for(;;)
+    // Pobranie serii elementów z bufora; 0 oznacza bufor zamknięty i pusty
+    size_t n;
+    while((n = worker_dequeue(args, files, batchSize)) > 0)
     {
-        // Sprawdzanie flagi zakończenia pracy
-        pthread_mutex_lock(args->mxQuitFlag);
-        bool quit = *(args->quitFlag);
-        pthread_mutex_unlock(args->mxQuitFlag);
+        if(args->ring != NULL)
+            process_uring_batch(files, n, args);
+        for(size_t i = 0; i < n; i++)
+        {
+            //printf("Pracownik %d reprezentuje plik %s\n", args->worker_id, files[i]);
+            if(args->ring == NULL)
+                process_file(files[i], args);
+            path_arena_release(files[i]); // chunk wraca do skanera po zwolnieniu ostatniej ścieżki
+        }
+    }
 
-        if (quit && args->buffer->count == 0)
-            break;
+    file_uring_deinit(args->ring);
+    return NULL;
+}
+
+ws_pool_t* ws_pool_init(int count, const char *startPath, const int *nodes)
+{
+    ws_pool_t *pool = malloc(sizeof(ws_pool_t));
+    if(pool == NULL)
+        ERR("malloc");
+    // każda deque na osobnych liniach cache
+    if(posix_memalign((void **)&pool->deques, WS_CACHE_LINE, sizeof(ws_deque) * count) != 0)
+        ERR("posix_memalign");
+    for(int i = 0; i < count; i++)
+        ws_deque_init(&pool->deques[i]);
+    pool->count = count;
+    pool->nodes = NULL;
+    if(nodes != NULL)
+    {
+        if((pool->nodes = malloc(sizeof(int) * count)) == NULL)
+            ERR("malloc");
+        memcpy(pool->nodes, nodes, sizeof(int) * count);
+    }
+    pool->pending = 0;
+    pool->idle = 0;
+    pool->stopped = false;
+    if(pthread_mutex_init(&pool->mxIdle, NULL) != 0)
+        ERR("pthread_mutex_init");
+    if(pthread_cond_init(&pool->cvIdle, NULL) != 0)
+        ERR("pthread_cond_init");
+
+    // wątki jeszcze nie działają, więc wątek główny może wstawić do deque pracownika 1
+    ws_pool_push(pool, 0, startPath, true);
+    return pool;
+}
+
+void ws_pool_deinit(ws_pool_t *pool)
+{
+    if(pool == NULL)
+        return;
+
+    // po SIGINT w deque mogą zostać porzucone zadania
+    for(int i = 0; i < pool->count; i++)
+    {
+        ws_task_t *task;
+        while((task = ws_deque_pop(&pool->deques[i])) != NULL)
+            free(task);
+        ws_deque_deinit(&pool->deques[i]);
+    }
+    pthread_cond_destroy(&pool->cvIdle);
+    pthread_mutex_destroy(&pool->mxIdle);
+    free(pool->deques);
+    free(pool->nodes);
+    free(pool);
+}
+
+// Budzi uśpionych pracowników; fence paruje się z inkrementacją idle w ws_pool_wait
+static void ws_pool_wake(ws_pool_t *pool, bool all)
+{
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if(__atomic_load_n(&pool->idle, __ATOMIC_RELAXED) == 0)
+        return;
+    pthread_mutex_lock(&pool->mxIdle);
+    if(all)
+        pthread_cond_broadcast(&pool->cvIdle);
+    else
+        pthread_cond_signal(&pool->cvIdle);
+    pthread_mutex_unlock(&pool->mxIdle);
+}
+
+void ws_pool_push(ws_pool_t *pool, int self, const char *path, bool isDirectory)
+{
+    size_t len = strlen(path);
+    ws_task_t *task = malloc(sizeof(ws_task_t) + len + 1);
+    if(task == NULL)
+        ERR("malloc");
+    task->isDirectory = isDirectory;
+    memcpy(task->path, path, len + 1);
+
+    __atomic_add_fetch(&pool->pending, 1, __ATOMIC_RELAXED);
+    ws_deque_push(&pool->deques[self], task);
+    ws_pool_wake(pool, false);
+}
+
+void ws_pool_stop(ws_pool_t *pool)
+{
+    pthread_mutex_lock(&pool->mxIdle);
+    __atomic_store_n(&pool->stopped, true, __ATOMIC_SEQ_CST);
+    pthread_cond_broadcast(&pool->cvIdle);
+    pthread_mutex_unlock(&pool->mxIdle);
+}
+
+static bool ws_pool_has_work(ws_pool_t *pool)
+{
+    for(int i = 0; i < pool->count; i++)
+        if(ws_deque_size(&pool->deques[i]) > 0)
+            return true;
+    return false;
+}
+
+static bool ws_pool_done(ws_pool_t *pool)
+{
+    return __atomic_load_n(&pool->pending, __ATOMIC_SEQ_CST) == 0 || __atomic_load_n(&pool->stopped, __ATOMIC_SEQ_CST);
+}
+
+// Zasypia, dopóki żadna deque nie ma zadań, a praca nie jest zakończona
+static void ws_pool_wait(ws_pool_t *pool)
+{
+    pthread_mutex_lock(&pool->mxIdle);
+    __atomic_add_fetch(&pool->idle, 1, __ATOMIC_SEQ_CST);
+    while(!ws_pool_has_work(pool) && !ws_pool_done(pool))
+        pthread_cond_wait(&pool->cvIdle, &pool->mxIdle);
+    __atomic_sub_fetch(&pool->idle, 1, __ATOMIC_SEQ_CST);
+    pthread_mutex_unlock(&pool->mxIdle);
+}
+
+// Najpierw własna deque (LIFO), potem kradzież od losowych ofiar (FIFO);
+// z przypięciem do węzłów najpierw ofiary z własnego węzła, potem z pozostałych
+static ws_task_t* ws_pool_find(ws_pool_t *pool, int self, unsigned int *seed)
+{
+    ws_task_t *task = ws_deque_pop(&pool->deques[self]);
+    if(task != NULL || pool->count == 1)
+        return task;
 
-        // Pobranie elementu z bufora
-        file_path = circular_buffer_dequeue(args->buffer);
-        if(file_path != NULL)
+    for(int local = pool->nodes != NULL; local >= 0; local--)
+    {
+        for(int i = 0; i < STEAL_ROUNDS * pool->count; i++)
         {
-            //printf("Pracownik %d reprezentuje plik %s\n", args->worker_id, file_path);
-            process_file(file_path, args->alphabetCounter, args->mutexes, args->worker_id, args->mxPrint);
-            free(file_path); // zwolnienie pamięci
+            int victim = rand_r(seed) % pool->count;
+            if(victim == self || (local && pool->nodes[victim] != pool->nodes[self]))
+                continue;
+            if((task = ws_deque_steal(&pool->deques[victim])) != NULL)
+                return task;
+        }
+    }
+    return NULL;
+}
+
+void* ws_worker_func(void* voidArgs)
+{
+    worker_args_t* args = voidArgs;
+    ws_pool_t *pool = args->pool;
+    int self = args->worker_id - 1;
+    ws_task_t *tasks[MAX_BATCH];
+    char *paths[MAX_BATCH];
+
+    uring_setup(args);
 
-            pthread_mutex_lock(args->mxProcessed);
-            (*args->processedFiles)++;
-            pthread_mutex_unlock(args->mxProcessed);
+    while(!__atomic_load_n(&pool->stopped, __ATOMIC_ACQUIRE))
+    {
+        ws_task_t *task = ws_pool_find(pool, self, &args->seed);
+        if(task == NULL)
+        {
+            if(ws_pool_done(pool))
+                break;
+            ws_pool_wait(pool);
+            continue;
         }
-        else 
+
+        long done = 1;
+        if(task->isDirectory)
+            dir_scan_at(AT_FDCWD, task->path, task->path, ws_explore_entry, args);
+        else if(args->ring != NULL)
         {
-            // Jeśli bufor jest pusty, wątek może chwilę poczekać
-            usleep(5000); // 5ms
+            // kolejne pliki z własnej deque trafiają do tej samej serii pierścienia,
+            // pierwszy napotkany katalog wraca na spód deque
+            size_t n = 0;
+            tasks[n] = task;
+            paths[n++] = task->path;
+            while(n < args->ioDepth && (task = ws_deque_pop(&pool->deques[self])) != NULL)
+            {
+                if(task->isDirectory)
+                {
+                    ws_deque_push(&pool->deques[self], task);
+                    break;
+                }
+                tasks[n] = task;
+                paths[n++] = task->path;
+            }
+            process_uring_batch(paths, n, args);
+            for(size_t i = 1; i < n; i++)
+                free(tasks[i]);
+            task = tasks[0];
+            done = n;
         }
+        else
+            process_file(task->path, args);
+        free(task);
+
+        // ostatnie zadanie - budzimy wszystkich, żeby zakończyli pracę
+        if(__atomic_sub_fetch(&pool->pending, done, __ATOMIC_SEQ_CST) == 0)
+            ws_pool_wake(pool, true);
     }
 
+    file_uring_deinit(args->ring);
     return NULL;
 }
 
-void process_file(const char* file_path, int *alphabetCounter, pthread_mutex_t *mutexes, int worker_id, pthread_mutex_t *mxPrint)
+// Podkatalogi i pliki .txt stają się zadaniami w deque pracownika
+bool ws_explore_entry(void *voidArgs, int dirFd, const char *name, const char *path, bool isDirectory)
 {
-    int fd = open(file_path, O_RDONLY);
-    if(fd == -1)
-        ERR("Cannot open file");
+    worker_args_t *args = voidArgs;
+    (void)dirFd;
+    (void)name;
 
-    int localCounter[52] = {0}; // lokalny licznik liter
-    char buffer[1024]; // bufor do odczytu danych
-    ssize_t bytesRead;
+    ws_pool_push(args->pool, args->worker_id - 1, path, isDirectory);
+    return true;
+}
 
-    while((bytesRead = read(fd, buffer, sizeof(buffer))) > 0)
+void process_file(const char* file_path, worker_args_t *args)
+{
+    uint64_t localCounter[LETTER_COUNT] = {0}; // lokalny licznik liter, A-Z: indeksy 0-25, a-z: 26-51
+    if(args->hist != NULL)
     {
-        for(ssize_t i = 0; i < bytesRead; i++)
-        {
-            char c = buffer[i];
-            if(isalpha(c))
-            {
-                int index;
-                if(isupper(c))
-                    index = c - 'A'; // A-Z: indeksy 0-25
-                else
-                    index = c - 'a' + 26; // a-z: indeksy 26-51
+        // litery ASCII pliku to przyrost sum pracownika - tabela 52 liter działa jak bez -a
+        uint64_t before[LETTER_COUNT];
+        utf8_hist_ascii(args->hist, before);
+        uint64_t bytes;
+        bool ok = file_io_count_utf8(file_path, args->ioMode, args->hist, &args->ioStats, &bytes);
+        utf8_hist_ascii(args->hist, localCounter);
+        for(int i = 0; i < LETTER_COUNT; i++)
+            localCounter[i] -= before[i];
+        if(ok)
+            merge_counts(file_path, localCounter, bytes, args);
+        return;
+    }
 
-                localCounter[index]++;
-            }
+    struct stat st;
+    if(args->cache != NULL)
+    {
+        // stat przed odczytem - zmiana pliku w trakcie da inny mtime przy następnym uruchomieniu
+        if(stat(file_path, &st) == -1)
+        {
+            perror(file_path); // plik usunięty w trakcie skanu
+            return;
+        }
+        if(count_cache_lookup(args->cache, args->worker_id - 1, &st, localCounter))
+        {
+            count_cache_record(args->cache, args->worker_id - 1, &st, localCounter);
+            merge_counts(file_path, localCounter, st.st_size, args);
+            return;
         }
     }
-    if(bytesRead == -1)
-        ERR("read");
 
-    close(fd);
+    // plik, którego nie da się otworzyć lub przeczytać, jest pomijany - tak samo w każdym trybie I/O
+    uint64_t bytes;
+    if(!file_io_count_letters(file_path, args->ioMode, localCounter, &args->ioStats, &bytes))
+        return;
+    if(args->cache != NULL)
+        count_cache_record(args->cache, args->worker_id - 1, &st, localCounter);
+    merge_counts(file_path, localCounter, bytes, args);
+}
 
-    // Akturalizacja globalnego licznika z użyciem mutexów
-    for(int i = 0; i < 52; i++)
+// Seria plików przez pierścień; z pamięcią podręczną czytane są tylko pliki bez trafienia
+void process_uring_batch(char **paths, size_t n, worker_args_t *args)
+{
+    uring_batch_t batch = { .args = args };
+    char *misses[MAX_BATCH];
+    size_t count = 0;
+    for(size_t i = 0; i < n; i++)
     {
-        if(localCounter[i] > 0)
+        if(args->cache != NULL)
         {
-            pthread_mutex_lock(&mutexes[i]);
-            alphabetCounter[i] += localCounter[i];
-            pthread_mutex_unlock(&mutexes[i]);
+            uint64_t counts[LETTER_COUNT];
+            if(stat(paths[i], &batch.st[count]) == -1)
+            {
+                perror(paths[i]);
+                continue;
+            }
+            if(count_cache_lookup(args->cache, args->worker_id - 1, &batch.st[count], counts))
+            {
+                count_cache_record(args->cache, args->worker_id - 1, &batch.st[count], counts);
+                merge_counts(paths[i], counts, batch.st[count].st_size, args);
+                continue;
+            }
         }
+        misses[count++] = paths[i];
     }
+    if(count > 0)
+        file_uring_count_letters(args->ring, misses, count, uring_file_done, &batch, &args->ioStats);
+}
+
+// Dodaje liczniki jednego pliku do globalnych i zgłasza plik do wypisania
+void merge_counts(const char* file_path, const uint64_t *localCounter, uint64_t bytes, worker_args_t *args)
+{
+    // Aktualizacja globalnego licznika - mutexy, atomiki albo prywatny histogram pracownika
+    letter_stats_add(args->letters, args->worker_id - 1, localCounter, bytes);
 
-    pthread_mutex_lock(mxPrint);
-    printf("Pracownik nr %d zakończył zliczanie liter w pliku %s\n", worker_id, file_path);
-    
-    print_alphabet_counters(alphabetCounter, mutexes);
+    // formatowanie i zapis robi wątek wyjścia, pracownik tylko kopiuje ścieżkę
+    result_writer_push(args->writer, args->worker_id, file_path);
+}
 
-    pthread_mutex_unlock(mxPrint);
+void uring_file_done(void *voidBatch, size_t index, const char *path, const uint64_t counts[LETTER_COUNT], uint64_t bytes)
+{
+    uring_batch_t *batch = voidBatch;
+    if(batch->args->cache != NULL)
+        count_cache_record(batch->args->cache, batch->args->worker_id - 1, &batch->st[index], counts);
+    merge_counts(path, counts, bytes, batch->args);
+}
+
+// Pierścień tworzy sam pracownik; bez io_uring wraca do blokującego process_file
+void uring_setup(worker_args_t *args)
+{
+    args->ring = NULL;
+    // pierścień liczy tylko ASCII - z -a pliki czyta process_file
+    if(args->ioMode != FILE_IO_URING || args->hist != NULL)
+        return;
+    args->ring = file_uring_init(args->ioDepth);
+    if(args->ring == NULL)
+    {
+        if(args->worker_id == 1)
+            perror("io_uring unavailable, falling back to read");
+        args->ioMode = FILE_IO_READ;
+    }
 }
 
 void* signal_handler_thread(void* voidArgs)
@@ -309,12 +1041,21 @@ void* signal_handler_thread(void* voidArgs)
             ERR("sigwait");
 
         if(sig == SIGUSR1)
-            print_alphabet_counters(args->alphabetCounter, args->mutexes);
+        {
+            print_progress(args->letters);
+#ifdef CB_STATS
+            for(int i = 0; i < args->queues->count; i++)
+                circular_buffer_print_stats(args->queues->buffers[i], stdout);
+#endif
+        }
         else if(sig == SIGINT)
         {
             pthread_mutex_lock(args->mxQuitFlag);
             *(args->quitFlag) = true;
             pthread_mutex_unlock(args->mxQuitFlag);
+            queue_shards_shutdown(args->queues);
+            if(args->pool != NULL)
+                ws_pool_stop(args->pool);
             break;
         }
     }
@@ -322,23 +1063,47 @@ void* signal_handler_thread(void* voidArgs)
     return NULL;
 }
 
-void print_alphabet_counters(int *alphabetCounter, pthread_mutex_t *mutexes)
+// Stan z migawki seqlock - nie blokuje pracowników
+void print_progress(letter_stats *letters)
+{
+    letter_snapshot snapshot;
+    letter_stats_snapshot(letters, &snapshot);
+
+    printf("Postęp: %lu plików, %.1f MiB, %.0f plików/s\n", (unsigned long)snapshot.files,
+           snapshot.bytes / 1048576.0, snapshot.seconds > 0 ? snapshot.files / snapshot.seconds : 0.0);
+    print_alphabet_counters(snapshot.counts);
+    fflush(stdout); // wyniki pracowników idą przez writev, bez bufora stdio
+}
+
+void print_alphabet_counters(const uint64_t *alphabetCounter)
 {
     printf("Wyniki:\n");
     for (int i = 0; i < 26; i++) 
     {
-        pthread_mutex_lock(&mutexes[i]);
         if(alphabetCounter[i] != 0)
-            printf("%c=%d ", 'A' + i, alphabetCounter[i]);
-        pthread_mutex_unlock(&mutexes[i]);
+            printf("%c=%lu ", 'A' + i, (unsigned long)alphabetCounter[i]);
     }
     printf("\n");
     for (int i = 26; i < 52; i++) 
     {
-        pthread_mutex_lock(&mutexes[i]);
         if(alphabetCounter[i] != 0)
-            printf("%c=%d ", 'a' + (i - 26), alphabetCounter[i]);
-        pthread_mutex_unlock(&mutexes[i]);
+            printf("%c=%lu ", 'a' + (i - 26), (unsigned long)alphabetCounter[i]);
     }
     printf("\n\n");
-}
\ No newline at end of file
+}
+void print_utf8_counters(const utf8_hist *hist)
+{
+    const utf8_alphabet *alphabet = hist->alphabet;
+    printf("Litery alfabetu:\n");
+    for(size_t i = 0; i < alphabet->count; i++)
+    {
+        uint64_t count = utf8_hist_get(hist, i);
+        if(count == 0)
+            continue;
+        char letter[4];
+        size_t len = utf8_encode(alphabet->letters[i], letter);
+        printf("%.*s=%lu ", (int)len, letter, (unsigned long)count);
+    }
+    printf("\nInne znaki: %lu, błędne sekwencje UTF-8: %lu\n",
+           (unsigned long)utf8_hist_get(hist, alphabet->count), (unsigned long)hist->invalid);
+}
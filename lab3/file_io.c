@@ -0,0 +1,201 @@
+#define _GNU_SOURCE
+#include "file_io.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#define ERR(source) (perror(source), fprintf(stderr, "%s:%d\n", __FILE__, __LINE__), exit(EXIT_FAILURE))
+
+#define SMALL_BUFFER 1024          // dotychczasowy bufor z process_file
+#define MMAP_MIN_SIZE (64 * 1024)  // poniżej tego rozmiaru mmap/munmap kosztuje więcej niż kopiowanie
+#define LARGE_BUFFER MMAP_MIN_SIZE // plik poniżej progu mmap mieści się w jednym read()
+
+static const char *mode_names[] = { "read", "mmap", "uring" };
+static const char *path_names[] = { "read", "read-large", "mmap", "uring" };
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+// Odbiorca odczytanych bajtów: histogram ASCII albo strumieniowy dekoder UTF-8
+typedef struct count_sink {
+    uint64_t *counts;
+    utf8_hist *hist;
+} count_sink;
+
+static void sink_count(const count_sink *sink, const unsigned char *data, size_t len)
+{
+    if(sink->hist != NULL)
+        utf8_hist_count(sink->hist, data, len);
+    else
+        letter_hist_count(data, len, sink->counts);
+}
+
+// Ten sam format co w file_uring.c - błąd jednego pliku nie kończy programu w żadnym trybie
+static void report_error(const char *what, const char *path)
+{
+    fprintf(stderr, "%s %s: %s\n", what, path, strerror(errno));
+}
+
+static bool read_loop(int fd, unsigned char *buffer, size_t size, const count_sink *sink, uint64_t *total)
+{
+    *total = 0;
+    ssize_t bytesRead;
+    while((bytesRead = read(fd, buffer, size)) > 0)
+    {
+        sink_count(sink, buffer, bytesRead);
+        *total += bytesRead;
+    }
+    return bytesRead == 0;
+}
+
+static bool read_small(int fd, const count_sink *sink, uint64_t *total)
+{
+    unsigned char buffer[SMALL_BUFFER];
+    return read_loop(fd, buffer, sizeof(buffer), sink, total);
+}
+
+static bool read_large(int fd, const count_sink *sink, uint64_t *total)
+{
+    unsigned char buffer[LARGE_BUFFER];
+    return read_loop(fd, buffer, sizeof(buffer), sink, total);
+}
+
+static bool read_mapped(int fd, size_t size, const count_sink *sink, uint64_t *total)
+{
+    void *data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if(data == MAP_FAILED)
+        return false;
+    // porada, nie warunek poprawności - błąd madvise ignorujemy
+    madvise(data, size, MADV_SEQUENTIAL);
+    sink_count(sink, data, size);
+    if(munmap(data, size) == -1)
+        ERR("munmap");
+    *total = size;
+    return true;
+}
+
+static bool count_file(const char *path, file_io_mode mode, const count_sink *sink, file_io_stats *stats, uint64_t *bytes)
+{
+    uint64_t start = stats != NULL ? now_ns() : 0;
+
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if(fd == -1)
+    {
+        // np. EACCES albo plik usunięty w trakcie skanu
+        report_error("Cannot open file", path);
+        return false;
+    }
+
+    file_io_path used = FILE_IO_PATH_READ;
+    bool ok;
+    if(mode == FILE_IO_MMAP)
+    {
+        struct stat st;
+        if(fstat(fd, &st) == -1)
+            ok = false;
+        // plik skrócony w trakcie zliczania skończy się SIGBUS - tak jak w każdym programie używającym mmap
+        else if(st.st_size >= MMAP_MIN_SIZE)
+        {
+            used = FILE_IO_PATH_MMAP;
+            ok = read_mapped(fd, st.st_size, sink, bytes);
+        }
+        else
+        {
+            used = FILE_IO_PATH_READ_LARGE;
+            ok = read_large(fd, sink, bytes);
+        }
+    }
+    else
+        ok = read_small(fd, sink, bytes);
+    if(!ok)
+        report_error("Cannot read file", path);
+
+    // plik przeczytany do końca, błąd close nie psuje jego liczników
+    if(close(fd) == -1)
+        report_error("Cannot close file", path);
+
+    if(ok && stats != NULL)
+    {
+        stats->files[used]++;
+        stats->bytes[used] += *bytes;
+        stats->ns[used] += now_ns() - start;
+    }
+    return ok;
+}
+
+bool file_io_count_letters(const char *path, file_io_mode mode, uint64_t counts[LETTER_COUNT], file_io_stats *stats,
+                           uint64_t *bytes)
+{
+    count_sink sink = { .counts = counts, .hist = NULL };
+    return count_file(path, mode, &sink, stats, bytes);
+}
+
+bool file_io_count_utf8(const char *path, file_io_mode mode, utf8_hist *hist, file_io_stats *stats, uint64_t *bytes)
+{
+    count_sink sink = { .counts = NULL, .hist = hist };
+    bool ok = count_file(path, mode, &sink, stats, bytes);
+    utf8_hist_finish(hist); // sekwencja ucięta końcem pliku nie łączy się z następnym plikiem
+    return ok;
+}
+
+void file_io_stats_add(file_io_stats *dst, const file_io_stats *src)
+{
+    for(int i = 0; i < FILE_IO_PATHS; i++)
+    {
+        dst->files[i] += src->files[i];
+        dst->bytes[i] += src->bytes[i];
+        dst->ns[i] += src->ns[i];
+    }
+}
+
+void file_io_stats_print(const file_io_stats *stats, file_io_mode mode, double seconds)
+{
+    uint64_t files = 0, bytes = 0;
+    for(int i = 0; i < FILE_IO_PATHS; i++)
+    {
+        files += stats->files[i];
+        bytes += stats->bytes[i];
+    }
+    printf("Tryb I/O %s: %lu plików, %.1f MiB w %.3f s, %.0f plików/s, %.1f MiB/s\n", mode_names[mode],
+           (unsigned long)files, bytes / 1048576.0, seconds, seconds > 0 ? files / seconds : 0.0,
+           seconds > 0 ? bytes / 1048576.0 / seconds : 0.0);
+
+    // czas sumowany po pracownikach - przepustowość pojedynczego wątku na danej ścieżce
+    for(int i = 0; i < FILE_IO_PATHS; i++)
+    {
+        if(stats->files[i] == 0)
+            continue;
+        double s = stats->ns[i] / 1e9;
+        printf("  %-10s %8lu plików %10.1f MiB %10.0f plików/s %10.1f MiB/s na wątek\n", path_names[i],
+               (unsigned long)stats->files[i], stats->bytes[i] / 1048576.0,
+               s > 0 ? stats->files[i] / s : 0.0, s > 0 ? stats->bytes[i] / 1048576.0 / s : 0.0);
+    }
+}
+
+bool file_io_parse_mode(const char *name, file_io_mode *mode)
+{
+    for(size_t i = 0; i < sizeof(mode_names) / sizeof(mode_names[0]); i++)
+    {
+        if(strcmp(name, mode_names[i]) == 0)
+        {
+            *mode = (file_io_mode)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* file_io_mode_name(file_io_mode mode)
+{
+    return mode_names[mode];
+}
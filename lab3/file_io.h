@@ -0,0 +1,74 @@
+#ifndef FILE_IO_H
+#define FILE_IO_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "letter_hist.h"
+#include "utf8_hist.h"
+
+typedef enum file_io_mode {
+    FILE_IO_READ, // read() through a small stack buffer
+    FILE_IO_MMAP, // read-only mapping with MADV_SEQUENTIAL, large read() for tiny files
+    FILE_IO_URING // batches of files through io_uring, see file_uring.h
+} file_io_mode;
+
+// How a single file was actually read; mmap mode uses both FILE_IO_PATH_MMAP and FILE_IO_PATH_READ_LARGE
+typedef enum file_io_path {
+    FILE_IO_PATH_READ,
+    FILE_IO_PATH_READ_LARGE,
+    FILE_IO_PATH_MMAP,
+    FILE_IO_PATH_URING,
+    FILE_IO_PATHS
+} file_io_path;
+
+/**
+ * Per-thread I/O counters. `ns` is the time spent opening, reading and
+ * counting, so bytes / ns is the throughput of one reading path.
+ */
+typedef struct file_io_stats {
+    uint64_t files[FILE_IO_PATHS];
+    uint64_t bytes[FILE_IO_PATHS];
+    uint64_t ns[FILE_IO_PATHS];
+} file_io_stats;
+
+/**
+ * Adds the letter counts of the file at `path` to counts, reading it the way
+ * `mode` says (FILE_IO_URING falls back to FILE_IO_READ here), and stores the
+ * number of bytes read in *bytes. `stats` may be NULL.
+ * A file that cannot be opened or read is reported on stderr and false is
+ * returned, as file_uring does; counts may then hold part of the file and
+ * should be dropped, and the file is left out of stats.
+ */
+bool file_io_count_letters(const char *path, file_io_mode mode, uint64_t counts[LETTER_COUNT], file_io_stats *stats,
+                           uint64_t *bytes);
+
+/**
+ * Same as file_io_count_letters, but decodes the file as UTF-8 into hist.
+ * Sequences split between reads are joined; one cut off by the end of the
+ * file is counted as invalid. Letters decoded before a read error stay in
+ * hist, only an open error leaves it unchanged.
+ */
+bool file_io_count_utf8(const char *path, file_io_mode mode, utf8_hist *hist, file_io_stats *stats, uint64_t *bytes);
+
+/**
+ * Adds the counters of src to dst.
+ */
+void file_io_stats_add(file_io_stats *dst, const file_io_stats *src);
+
+/**
+ * Prints the totals for the whole run (wall-clock time `seconds`, files/s and
+ * MiB/s) and the throughput of each reading path that was used.
+ */
+void file_io_stats_print(const file_io_stats *stats, file_io_mode mode, double seconds);
+
+/**
+ * Parses "read", "mmap" or "uring". Returns false on unknown names.
+ */
+bool file_io_parse_mode(const char *name, file_io_mode *mode);
+
+/**
+ * Returns the name of the mode as accepted by file_io_parse_mode.
+ */
+const char* file_io_mode_name(file_io_mode mode);
+
+#endif // FILE_IO_H
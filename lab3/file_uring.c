@@ -0,0 +1,335 @@
+#define _GNU_SOURCE
+#include "file_uring.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#define ERR(source) (perror(source), fprintf(stderr, "%s:%d\n", __FILE__, __LINE__), exit(EXIT_FAILURE))
+
+#define SLOT_BUFFER (64 * 1024) // bufor odczytu jednego pliku w locie
+
+// user_data = numer slotu << 2 | rodzaj operacji
+#define OP_OPEN 0
+#define OP_READ 1
+#define OP_CLOSE 2
+#define OP_BITS 2
+
+typedef struct uring_slot {
+    const char *path;
+    int fd;
+    bool failed;            // błąd otwarcia lub odczytu - plik zgłoszony, liczniki pominięte
+    uint64_t offset;
+    uint64_t counts[LETTER_COUNT];
+} uring_slot;
+
+struct file_uring {
+    int fd;
+    unsigned depth;
+
+    // kolejka zgłoszeń (SQ) - wskaźniki do pól w pamięci współdzielonej z jądrem
+    unsigned *sqHead;
+    unsigned *sqTail;
+    unsigned sqMask;
+    unsigned *sqArray;
+    struct io_uring_sqe *sqes;
+    unsigned toSubmit;      // wpisane do SQ, jeszcze nieprzekazane przez io_uring_enter
+
+    // kolejka zakończeń (CQ)
+    unsigned *cqHead;
+    unsigned *cqTail;
+    unsigned cqMask;
+    struct io_uring_cqe *cqes;
+
+    void *sqRing;
+    size_t sqRingSize;
+    void *cqRing;           // ten sam obszar co sqRing przy IORING_FEAT_SINGLE_MMAP
+    size_t cqRingSize;
+    size_t sqesSize;
+
+    uring_slot *slots;
+    unsigned char *buffers; // depth buforów po SLOT_BUFFER bajtów
+};
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+static int sys_io_uring_setup(unsigned entries, struct io_uring_params *params)
+{
+    return (int)syscall(__NR_io_uring_setup, entries, params);
+}
+
+static int sys_io_uring_enter(int fd, unsigned toSubmit, unsigned minComplete, unsigned flags)
+{
+    return (int)syscall(__NR_io_uring_enter, fd, toSubmit, minComplete, flags, NULL, 0);
+}
+
+// Czy jądro obsługuje OPENAT, READ i CLOSE; io_uring sprzed 5.6 nie ma ani tych operacji, ani IORING_REGISTER_PROBE
+static bool ops_supported(int fd)
+{
+    static const unsigned char needed[] = { IORING_OP_OPENAT, IORING_OP_READ, IORING_OP_CLOSE };
+    size_t size = sizeof(struct io_uring_probe) + IORING_OP_LAST * sizeof(struct io_uring_probe_op);
+    struct io_uring_probe *probe = calloc(1, size);
+    if(probe == NULL)
+        ERR("calloc");
+    bool supported = syscall(__NR_io_uring_register, fd, IORING_REGISTER_PROBE, probe, IORING_OP_LAST) == 0;
+    for(size_t i = 0; supported && i < sizeof(needed); i++)
+        supported = needed[i] <= probe->last_op && needed[i] < probe->ops_len &&
+                    (probe->ops[needed[i]].flags & IO_URING_OP_SUPPORTED);
+    free(probe);
+    return supported;
+}
+
+file_uring* file_uring_init(unsigned depth)
+{
+    if(depth == 0)
+        depth = FILE_URING_DEFAULT_DEPTH;
+
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    // każdy slot ma w locie najwyżej jedną operację, więc depth wpisów w SQ i CQ wystarcza
+    int fd = sys_io_uring_setup(depth, &params);
+    if(fd == -1)
+        return NULL;
+    if(!ops_supported(fd))
+    {
+        close(fd);
+        errno = EOPNOTSUPP;
+        return NULL;
+    }
+
+    file_uring *ring = calloc(1, sizeof(file_uring));
+    if(ring == NULL)
+        ERR("calloc");
+    ring->fd = fd;
+    ring->depth = depth;
+
+    ring->sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    ring->cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    bool single = params.features & IORING_FEAT_SINGLE_MMAP;
+    if(single && ring->cqRingSize > ring->sqRingSize)
+        ring->sqRingSize = ring->cqRingSize;
+
+    ring->sqRing = mmap(NULL, ring->sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    if(ring->sqRing == MAP_FAILED)
+        ERR("mmap");
+    if(single)
+    {
+        ring->cqRing = ring->sqRing;
+        ring->cqRingSize = 0;
+    }
+    else
+    {
+        ring->cqRing = mmap(NULL, ring->cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+        if(ring->cqRing == MAP_FAILED)
+            ERR("mmap");
+    }
+    ring->sqesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+    ring->sqes = mmap(NULL, ring->sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+    if(ring->sqes == MAP_FAILED)
+        ERR("mmap");
+
+    char *sq = ring->sqRing;
+    ring->sqHead = (unsigned *)(sq + params.sq_off.head);
+    ring->sqTail = (unsigned *)(sq + params.sq_off.tail);
+    ring->sqMask = *(unsigned *)(sq + params.sq_off.ring_mask);
+    ring->sqArray = (unsigned *)(sq + params.sq_off.array);
+
+    char *cq = ring->cqRing;
+    ring->cqHead = (unsigned *)(cq + params.cq_off.head);
+    ring->cqTail = (unsigned *)(cq + params.cq_off.tail);
+    ring->cqMask = *(unsigned *)(cq + params.cq_off.ring_mask);
+    ring->cqes = (struct io_uring_cqe *)(cq + params.cq_off.cqes);
+
+    ring->slots = calloc(depth, sizeof(uring_slot));
+    ring->buffers = malloc((size_t)depth * SLOT_BUFFER);
+    if(ring->slots == NULL || ring->buffers == NULL)
+        ERR("malloc");
+    return ring;
+}
+
+void file_uring_deinit(file_uring *ring)
+{
+    if(ring == NULL)
+        return;
+    munmap(ring->sqes, ring->sqesSize);
+    if(ring->cqRing != ring->sqRing)
+        munmap(ring->cqRing, ring->cqRingSize);
+    munmap(ring->sqRing, ring->sqRingSize);
+    close(ring->fd);
+    free(ring->slots);
+    free(ring->buffers);
+    free(ring);
+}
+
+unsigned file_uring_depth(const file_uring *ring)
+{
+    return ring->depth;
+}
+
+// Miejsce w SQ jest zawsze wolne - slotów jest tyle, ile wpisów kolejki
+static struct io_uring_sqe* get_sqe(file_uring *ring, unsigned slot, unsigned op)
+{
+    unsigned tail = *ring->sqTail; // tail modyfikujemy tylko my
+    unsigned index = tail & ring->sqMask;
+    struct io_uring_sqe *sqe = &ring->sqes[index];
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->user_data = (uint64_t)slot << OP_BITS | op;
+    ring->sqArray[index] = index;
+    __atomic_store_n(ring->sqTail, tail + 1, __ATOMIC_RELEASE);
+    ring->toSubmit++;
+    return sqe;
+}
+
+static void prep_read(file_uring *ring, unsigned slot)
+{
+    struct io_uring_sqe *sqe = get_sqe(ring, slot, OP_READ);
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = ring->slots[slot].fd;
+    sqe->addr = (uint64_t)(uintptr_t)(ring->buffers + (size_t)slot * SLOT_BUFFER);
+    sqe->len = SLOT_BUFFER;
+    sqe->off = ring->slots[slot].offset;
+}
+
+static void prep_close(file_uring *ring, unsigned slot)
+{
+    struct io_uring_sqe *sqe = get_sqe(ring, slot, OP_CLOSE);
+    sqe->opcode = IORING_OP_CLOSE;
+    sqe->fd = ring->slots[slot].fd;
+}
+
+static void prep_open(file_uring *ring, unsigned slot)
+{
+    struct io_uring_sqe *sqe = get_sqe(ring, slot, OP_OPEN);
+    sqe->opcode = IORING_OP_OPENAT;
+    sqe->fd = AT_FDCWD;
+    sqe->addr = (uint64_t)(uintptr_t)ring->slots[slot].path;
+    sqe->open_flags = O_RDONLY | O_CLOEXEC;
+}
+
+// Błąd jednego pliku nie przerywa skanu: komunikat jak perror w ścieżce read, plik bez liczników
+static void report_error(const char *what, const char *path, int res)
+{
+    fprintf(stderr, "%s %s: %s\n", what, path, strerror(-res));
+}
+
+// Jedna seria, n <= depth; paths[i] jest w wywołaniu cb plikiem first + i
+static void count_batch(file_uring *ring, char **paths, size_t n, size_t first, file_uring_done_cb cb, void *ctx,
+                        uint64_t *files, uint64_t *bytes, uint64_t *callbackNs)
+{
+    for(unsigned i = 0; i < n; i++)
+    {
+        ring->slots[i].path = paths[i];
+        ring->slots[i].fd = -1;
+        ring->slots[i].failed = false;
+        ring->slots[i].offset = 0;
+        memset(ring->slots[i].counts, 0, sizeof(ring->slots[i].counts));
+        prep_open(ring, i);
+    }
+
+    size_t remaining = n;
+    while(remaining > 0)
+    {
+        // przekazanie nowych zgłoszeń i czekanie na co najmniej jedno zakończenie
+        int submitted = sys_io_uring_enter(ring->fd, ring->toSubmit, 1, IORING_ENTER_GETEVENTS);
+        if(submitted == -1)
+        {
+            if(errno == EINTR)
+                continue;
+            ERR("io_uring_enter");
+        }
+        ring->toSubmit -= submitted;
+
+        unsigned head = *ring->cqHead;
+        unsigned tail = __atomic_load_n(ring->cqTail, __ATOMIC_ACQUIRE);
+        for(; head != tail; head++)
+        {
+            struct io_uring_cqe *cqe = &ring->cqes[head & ring->cqMask];
+            unsigned slot = cqe->user_data >> OP_BITS;
+            unsigned op = cqe->user_data & ((1u << OP_BITS) - 1);
+            int res = cqe->res;
+            uring_slot *s = &ring->slots[slot];
+
+            switch(op)
+            {
+                case OP_OPEN:
+                    if(res < 0)
+                    {
+                        // np. EACCES albo plik usunięty w trakcie skanu - nie ma czego zamykać
+                        report_error("Cannot open file", s->path, res);
+                        remaining--;
+                        break;
+                    }
+                    s->fd = res;
+                    prep_read(ring, slot);
+                    break;
+                case OP_READ:
+                    if(res > 0)
+                    {
+                        letter_hist_count(ring->buffers + (size_t)slot * SLOT_BUFFER, res, s->counts);
+                        s->offset += res;
+                        prep_read(ring, slot); // dopiero odczyt 0 bajtów oznacza koniec pliku
+                    }
+                    else
+                    {
+                        if(res < 0)
+                        {
+                            report_error("Cannot read file", s->path, res);
+                            s->failed = true;
+                        }
+                        prep_close(ring, slot);
+                    }
+                    break;
+                case OP_CLOSE:
+                {
+                    // plik przeczytany do końca, błąd close nie psuje jego liczników
+                    if(res < 0)
+                        report_error("Cannot close file", s->path, res);
+                    if(!s->failed)
+                    {
+                        uint64_t cbStart = now_ns();
+                        cb(ctx, first + slot, s->path, s->counts, s->offset);
+                        *callbackNs += now_ns() - cbStart;
+                        (*files)++;
+                        *bytes += s->offset; // bajty odrzuconego pliku nie wchodzą do przepustowości
+                    }
+                    remaining--;
+                    break;
+                }
+            }
+        }
+        __atomic_store_n(ring->cqHead, head, __ATOMIC_RELEASE);
+    }
+}
+
+void file_uring_count_letters(file_uring *ring, char **paths, size_t n, file_uring_done_cb cb, void *ctx, file_io_stats *stats)
+{
+    uint64_t start = now_ns();
+    uint64_t files = 0;
+    uint64_t bytes = 0;
+    uint64_t callbackNs = 0; // czas w cb nie jest czasem odczytu
+
+    // slotów jest depth, dłuższa lista idzie kolejnymi seriami
+    for(size_t done = 0; done < n; done += ring->depth)
+    {
+        size_t count = n - done < ring->depth ? n - done : ring->depth;
+        count_batch(ring, paths + done, count, done, cb, ctx, &files, &bytes, &callbackNs);
+    }
+
+    if(stats != NULL)
+    {
+        stats->files[FILE_IO_PATH_URING] += files;
+        stats->bytes[FILE_IO_PATH_URING] += bytes;
+        stats->ns[FILE_IO_PATH_URING] += now_ns() - start - callbackNs;
+    }
+}
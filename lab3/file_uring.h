@@ -0,0 +1,45 @@
+#ifndef FILE_URING_H
+#define FILE_URING_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "letter_hist.h"
+#include "file_io.h"
+
+#define FILE_URING_DEFAULT_DEPTH 32
+
+typedef struct file_uring file_uring;
+
+/*
+ * Called once for every file, as soon as its close completes. `index` is the
+ * file's position in `paths`, `counts` holds the letters of this file only and
+ * is valid during the call, `bytes` is the file size read.
+ */
+typedef void (*file_uring_done_cb)(void *ctx, size_t index, const char *path, const uint64_t counts[LETTER_COUNT], uint64_t bytes);
+
+/**
+ * Creates an io_uring instance that keeps up to `depth` files in flight.
+ * Talks to the kernel through raw syscalls, no liburing needed. Returns NULL
+ * when io_uring is not available (old kernel, seccomp, io_uring_disabled) or
+ * lacks the openat/read/close opcodes (kernels before 5.6, errno EOPNOTSUPP);
+ * callers should fall back to file_io_count_letters then.
+ * A ring belongs to one thread.
+ */
+file_uring* file_uring_init(unsigned depth);
+
+void file_uring_deinit(file_uring *ring);
+
+unsigned file_uring_depth(const file_uring *ring);
+
+/**
+ * Opens, reads and closes paths[0..n) through the ring. Every file goes
+ * openat -> read... -> close, the next request being submitted from the
+ * completion of the previous one, so up to depth files overlap; longer lists
+ * are processed in consecutive batches of depth. A file that cannot be opened
+ * or read is reported on stderr and skipped, cb is not called for it.
+ * Adds to stats->*[FILE_IO_PATH_URING] the files counted, their bytes and the
+ * wall time, not counting the time in cb.
+ */
+void file_uring_count_letters(file_uring *ring, char **paths, size_t n, file_uring_done_cb cb, void *ctx, file_io_stats *stats);
+
+#endif // FILE_URING_H
@@ -0,0 +1,244 @@
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Generator syntetycznych drzew katalogów do pomiarów etap4: `depth` poziomów
+// podkatalogów po `fanout` w każdym, `files` plików .txt rozłożonych po równo
+// na wszystkie katalogi, rozmiary z podanego rozkładu. Treść to losowy tekst
+// (litery, spacje, interpunkcja); to samo ziarno daje to samo drzewo.
+// Użycie: ./gen_tree [-d depth] [-f fanout] [-n files] [-s size] [-S seed] directory
+//   size: fixed:N | uniform:MIN:MAX | exp:MEAN (wykładniczy, dużo małych plików)
+
+#define DEFAULT_DEPTH 3
+#define DEFAULT_FANOUT 4
+#define DEFAULT_FILES 10000
+#define TEXT_SIZE (1 << 20) // wzorzec tekstu, z którego kopiowane są fragmenty
+#define MAX_FILE_SIZE (1ull << 30)
+
+#define ERR(source) (perror(source), fprintf(stderr, "%s:%d\n", __FILE__, __LINE__), exit(EXIT_FAILURE))
+
+typedef enum size_dist { SIZE_FIXED, SIZE_UNIFORM, SIZE_EXP } size_dist;
+
+typedef struct gen_options {
+    int depth;
+    int fanout;
+    long files;
+    size_dist dist;
+    uint64_t sizeA;    // fixed: rozmiar, uniform: minimum, exp: średnia
+    uint64_t sizeB;    // uniform: maksimum
+    unsigned int seed;
+    const char *root;
+} gen_options;
+
+typedef struct gen_state {
+    const gen_options *options;
+    char *text;
+    long dirs;         // katalogi w całym drzewie
+    long dirIndex;     // numer bieżącego katalogu w kolejności tworzenia
+    long filesDone;
+    uint64_t bytes;
+    unsigned int seed;
+} gen_state;
+
+static void usage(const char *name)
+{
+    fprintf(stderr, "Usage: %s [-d depth] [-f fanout] [-n files] [-s fixed:N|uniform:MIN:MAX|exp:MEAN] [-S seed] directory\n", name);
+    exit(EXIT_FAILURE);
+}
+
+static bool parse_size(const char *arg, gen_options *options)
+{
+    unsigned long long a, b;
+    char tail;
+    if (sscanf(arg, "fixed:%llu%c", &a, &tail) == 1)
+    {
+        options->dist = SIZE_FIXED;
+        options->sizeA = a;
+    }
+    else if (sscanf(arg, "uniform:%llu:%llu%c", &a, &b, &tail) == 2 && a <= b)
+    {
+        options->dist = SIZE_UNIFORM;
+        options->sizeA = a;
+        options->sizeB = b;
+    }
+    else if (sscanf(arg, "exp:%llu%c", &a, &tail) == 1 && a > 0)
+    {
+        options->dist = SIZE_EXP;
+        options->sizeA = a;
+    }
+    else
+        return false;
+    return options->sizeA <= MAX_FILE_SIZE && options->sizeB <= MAX_FILE_SIZE;
+}
+
+static void read_args(int argc, char **argv, gen_options *options)
+{
+    options->depth = DEFAULT_DEPTH;
+    options->fanout = DEFAULT_FANOUT;
+    options->files = DEFAULT_FILES;
+    options->dist = SIZE_EXP;
+    options->sizeA = 4096;
+    options->sizeB = 0;
+    options->seed = 12345;
+
+    int c;
+    while ((c = getopt(argc, argv, "d:f:n:s:S:")) != -1)
+    {
+        switch (c)
+        {
+            case 'd':
+                options->depth = atoi(optarg);
+                if (options->depth < 0)
+                    ERR("Invalid depth");
+                break;
+            case 'f':
+                options->fanout = atoi(optarg);
+                if (options->fanout < 1)
+                    ERR("Invalid fanout");
+                break;
+            case 'n':
+                options->files = atol(optarg);
+                if (options->files < 0)
+                    ERR("Invalid file count");
+                break;
+            case 's':
+                if (!parse_size(optarg, options))
+                    ERR("Invalid size distribution");
+                break;
+            case 'S':
+                options->seed = strtoul(optarg, NULL, 10);
+                break;
+            default:
+                usage(argv[0]);
+        }
+    }
+    if (argc - optind != 1)
+        usage(argv[0]);
+    options->root = argv[optind];
+}
+
+static uint64_t draw_size(gen_state *state)
+{
+    const gen_options *options = state->options;
+    double u = (rand_r(&state->seed) + 1.0) / (RAND_MAX + 2.0); // (0, 1)
+    switch (options->dist)
+    {
+        case SIZE_FIXED:
+            return options->sizeA;
+        case SIZE_UNIFORM:
+            return options->sizeA + (uint64_t)(u * (options->sizeB - options->sizeA + 1));
+        case SIZE_EXP:
+        default:
+        {
+            double size = -log(u) * options->sizeA;
+            return size > MAX_FILE_SIZE ? MAX_FILE_SIZE : (uint64_t)size;
+        }
+    }
+}
+
+static void write_file(gen_state *state, const char *path, uint64_t size)
+{
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd == -1)
+        ERR("Cannot create file");
+    while (size > 0)
+    {
+        // fragment wzorca od losowego miejsca - pliki różnią się treścią, a generowanie jest tanie
+        size_t offset = rand_r(&state->seed) % TEXT_SIZE;
+        size_t chunk = TEXT_SIZE - offset < size ? TEXT_SIZE - offset : size;
+        ssize_t written = write(fd, state->text + offset, chunk);
+        if (written == -1)
+        {
+            if (errno == EINTR)
+                continue;
+            ERR("write");
+        }
+        size -= written;
+        state->bytes += written;
+    }
+    if (close(fd) == -1)
+        ERR("close");
+}
+
+static void fill_text(char *text, size_t len, unsigned int seed)
+{
+    static const char extra[] = "  \n.,;-!?";
+    for (size_t i = 0; i < len; i++)
+    {
+        int r = rand_r(&seed) % 100;
+        if (r < 75)
+            text[i] = 'a' + rand_r(&seed) % 26;
+        else if (r < 80)
+            text[i] = 'A' + rand_r(&seed) % 26;
+        else
+            text[i] = extra[rand_r(&seed) % (sizeof(extra) - 1)];
+    }
+}
+
+// Katalog `path` na poziomie `level`: jego część plików, potem podkatalogi
+static void generate(gen_state *state, const char *path, int level)
+{
+    const gen_options *options = state->options;
+    if (mkdir(path, 0755) == -1 && errno != EEXIST)
+        ERR("mkdir");
+
+    // pliki po równo, reszta z dzielenia w pierwszych katalogach
+    long index = state->dirIndex++;
+    long count = options->files / state->dirs + (index < options->files % state->dirs ? 1 : 0);
+    char child[PATH_MAX];
+    for (long i = 0; i < count; i++)
+    {
+        if (snprintf(child, sizeof(child), "%s/plik%ld.txt", path, state->filesDone) >= (int)sizeof(child))
+            ERR("Path too long");
+        write_file(state, child, draw_size(state));
+        state->filesDone++;
+    }
+
+    if (level == options->depth)
+        return;
+    for (int i = 0; i < options->fanout; i++)
+    {
+        if (snprintf(child, sizeof(child), "%s/korytarz%d", path, i) >= (int)sizeof(child))
+            ERR("Path too long");
+        generate(state, child, level + 1);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    gen_options options;
+    read_args(argc, argv, &options);
+
+    gen_state state = { .options = &options, .dirIndex = 0, .filesDone = 0, .bytes = 0, .seed = options.seed };
+    // 1 + f + f^2 + ... + f^depth katalogów
+    long levelDirs = 1;
+    state.dirs = 0;
+    for (int level = 0; level <= options.depth; level++)
+    {
+        state.dirs += levelDirs;
+        if (levelDirs > LONG_MAX / options.fanout)
+            ERR("Tree too large");
+        levelDirs *= options.fanout;
+    }
+
+    state.text = malloc(TEXT_SIZE);
+    if (state.text == NULL)
+        ERR("malloc");
+    fill_text(state.text, TEXT_SIZE, options.seed);
+
+    generate(&state, options.root, 0);
+    printf("Utworzono %ld katalogów, %ld plików, %.1f MiB w %s\n", state.dirs, state.filesDone,
+           state.bytes / 1048576.0, options.root);
+
+    free(state.text);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,196 @@
+#include "letter_hist.h"
+#include <pthread.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define LETTER_HIST_X86 1
+#endif
+
+#define SUB_HISTS 4                 // przeplatane podhistogramy - kolejne bajty trafiają do różnych tablic
+#define BIN_COUNT (LETTER_COUNT + 1) // ostatni kosz zbiera znaki niebędące literami
+#define NOT_LETTER LETTER_COUNT
+#define MAX_CHUNK (1u << 30)        // liczniki uint32 w podhistogramach nie mogą się przepełnić
+
+typedef void (*hist_kernel)(const unsigned char *data, size_t len, uint32_t sub[SUB_HISTS][BIN_COUNT]);
+
+static hist_kernel selectedKernel;
+static const char *selectedName;
+static pthread_once_t selectOnce = PTHREAD_ONCE_INIT;
+
+static inline unsigned letter_index(unsigned char c)
+{
+    if ((unsigned char)(c - 'A') < 26)
+        return c - 'A';      // A-Z: indeksy 0-25
+    if ((unsigned char)(c - 'a') < 26)
+        return c - 'a' + 26; // a-z: indeksy 26-51
+    return NOT_LETTER;
+}
+
+static void scalar_kernel(const unsigned char *data, size_t len, uint32_t sub[SUB_HISTS][BIN_COUNT])
+{
+    size_t i = 0;
+    for (; i + SUB_HISTS <= len; i += SUB_HISTS)
+    {
+        sub[0][letter_index(data[i])]++;
+        sub[1][letter_index(data[i + 1])]++;
+        sub[2][letter_index(data[i + 2])]++;
+        sub[3][letter_index(data[i + 3])]++;
+    }
+    for (; i < len; i++)
+        sub[0][letter_index(data[i])]++;
+}
+
+// Dzieli dane na fragmenty, zeruje podhistogramy i sumuje je do counts
+static void run_kernel(hist_kernel kernel, const unsigned char *data, size_t len, uint64_t counts[LETTER_COUNT])
+{
+    uint32_t sub[SUB_HISTS][BIN_COUNT];
+    while (len > 0)
+    {
+        size_t n = len < MAX_CHUNK ? len : MAX_CHUNK;
+        memset(sub, 0, sizeof(sub));
+        kernel(data, n, sub);
+        for (int i = 0; i < LETTER_COUNT; i++)
+            counts[i] += (uint64_t)sub[0][i] + sub[1][i] + sub[2][i] + sub[3][i];
+        data += n;
+        len -= n;
+    }
+}
+
+void letter_hist_scalar(const unsigned char *data, size_t len, uint64_t counts[LETTER_COUNT])
+{
+    run_kernel(scalar_kernel, data, len, counts);
+}
+
+#ifdef LETTER_HIST_X86
+
+// Klasyfikacja bajtów porównaniem ze znakiem: v + (0x80 - 'A') < 0x80 + 26 tylko dla 'A'..'Z'.
+// Indeksy koszy zapisujemy do tablicy i zliczamy w SUB_HISTS podhistogramach na zmianę.
+
+__attribute__((target("sse2")))
+static void sse2_kernel(const unsigned char *data, size_t len, uint32_t sub[SUB_HISTS][BIN_COUNT])
+{
+    const __m128i biasUpper = _mm_set1_epi8((char)(0x80 - 'A'));
+    const __m128i biasLower = _mm_set1_epi8((char)(0x80 - 'a'));
+    const __m128i limit = _mm_set1_epi8((char)(0x80 + 26));
+    const __m128i offUpper = _mm_set1_epi8('A');
+    const __m128i offLower = _mm_set1_epi8('a' - 26);
+    const __m128i none = _mm_set1_epi8(NOT_LETTER);
+    unsigned char idx[32] __attribute__((aligned(16)));
+
+    size_t i = 0;
+    for (; i + 32 <= len; i += 32)
+    {
+        __m128i v0 = _mm_loadu_si128((const __m128i *)(data + i));
+        __m128i v1 = _mm_loadu_si128((const __m128i *)(data + i + 16));
+        __m128i up0 = _mm_cmplt_epi8(_mm_add_epi8(v0, biasUpper), limit);
+        __m128i up1 = _mm_cmplt_epi8(_mm_add_epi8(v1, biasUpper), limit);
+        __m128i lo0 = _mm_cmplt_epi8(_mm_add_epi8(v0, biasLower), limit);
+        __m128i lo1 = _mm_cmplt_epi8(_mm_add_epi8(v1, biasLower), limit);
+        __m128i let0 = _mm_or_si128(up0, lo0);
+        __m128i let1 = _mm_or_si128(up1, lo1);
+        if (_mm_movemask_epi8(_mm_or_si128(let0, let1)) == 0)
+            continue; // 32 bajty bez liter
+
+        __m128i ix0 = _mm_or_si128(_mm_or_si128(_mm_and_si128(up0, _mm_sub_epi8(v0, offUpper)),
+                                                _mm_and_si128(lo0, _mm_sub_epi8(v0, offLower))),
+                                   _mm_andnot_si128(let0, none));
+        __m128i ix1 = _mm_or_si128(_mm_or_si128(_mm_and_si128(up1, _mm_sub_epi8(v1, offUpper)),
+                                                _mm_and_si128(lo1, _mm_sub_epi8(v1, offLower))),
+                                   _mm_andnot_si128(let1, none));
+        _mm_store_si128((__m128i *)idx, ix0);
+        _mm_store_si128((__m128i *)(idx + 16), ix1);
+        for (int j = 0; j < 32; j += SUB_HISTS)
+        {
+            sub[0][idx[j]]++;
+            sub[1][idx[j + 1]]++;
+            sub[2][idx[j + 2]]++;
+            sub[3][idx[j + 3]]++;
+        }
+    }
+    scalar_kernel(data + i, len - i, sub);
+}
+
+__attribute__((target("avx2")))
+static void avx2_kernel(const unsigned char *data, size_t len, uint32_t sub[SUB_HISTS][BIN_COUNT])
+{
+    const __m256i biasUpper = _mm256_set1_epi8((char)(0x80 - 'A'));
+    const __m256i biasLower = _mm256_set1_epi8((char)(0x80 - 'a'));
+    const __m256i limit = _mm256_set1_epi8((char)(0x80 + 26));
+    const __m256i offUpper = _mm256_set1_epi8('A');
+    const __m256i offLower = _mm256_set1_epi8('a' - 26);
+    const __m256i none = _mm256_set1_epi8(NOT_LETTER);
+    unsigned char idx[32] __attribute__((aligned(32)));
+
+    size_t i = 0;
+    for (; i + 32 <= len; i += 32)
+    {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(data + i));
+        __m256i upper = _mm256_cmpgt_epi8(limit, _mm256_add_epi8(v, biasUpper));
+        __m256i lower = _mm256_cmpgt_epi8(limit, _mm256_add_epi8(v, biasLower));
+        __m256i letters = _mm256_or_si256(upper, lower);
+        if (_mm256_testz_si256(letters, letters))
+            continue; // 32 bajty bez liter
+
+        __m256i ix = _mm256_or_si256(_mm256_or_si256(_mm256_and_si256(upper, _mm256_sub_epi8(v, offUpper)),
+                                                     _mm256_and_si256(lower, _mm256_sub_epi8(v, offLower))),
+                                     _mm256_andnot_si256(letters, none));
+        // dwa zapisy 128-bitowe - odczyty pojedynczych bajtów dostają je z store forwardingu
+        _mm_store_si128((__m128i *)idx, _mm256_castsi256_si128(ix));
+        _mm_store_si128((__m128i *)(idx + 16), _mm256_extracti128_si256(ix, 1));
+        for (int j = 0; j < 32; j += SUB_HISTS)
+        {
+            sub[0][idx[j]]++;
+            sub[1][idx[j + 1]]++;
+            sub[2][idx[j + 2]]++;
+            sub[3][idx[j + 3]]++;
+        }
+    }
+    scalar_kernel(data + i, len - i, sub);
+}
+
+void letter_hist_sse2(const unsigned char *data, size_t len, uint64_t counts[LETTER_COUNT])
+{
+    run_kernel(sse2_kernel, data, len, counts);
+}
+
+void letter_hist_avx2(const unsigned char *data, size_t len, uint64_t counts[LETTER_COUNT])
+{
+    run_kernel(avx2_kernel, data, len, counts);
+}
+
+bool letter_hist_avx2_supported(void)
+{
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+}
+
+#endif // LETTER_HIST_X86
+
+static void select_kernel(void)
+{
+    selectedKernel = scalar_kernel;
+    selectedName = "scalar";
+#ifdef LETTER_HIST_X86
+    // avx2 nie jest wybierane: oba jądra kończą się tą samą skalarną pętlą po 32 indeksach,
+    // a szersza klasyfikacja nic nie daje - w bench_hist avx2 jest ponad 2x wolniejsze od sse2
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse2"))
+    {
+        selectedKernel = sse2_kernel;
+        selectedName = "sse2";
+    }
+#endif
+}
+
+void letter_hist_count(const unsigned char *data, size_t len, uint64_t counts[LETTER_COUNT])
+{
+    pthread_once(&selectOnce, select_kernel);
+    run_kernel(selectedKernel, data, len, counts);
+}
+
+const char* letter_hist_impl_name(void)
+{
+    pthread_once(&selectOnce, select_kernel);
+    return selectedName;
+}
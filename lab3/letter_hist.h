@@ -0,0 +1,33 @@
+#ifndef LETTER_HIST_H
+#define LETTER_HIST_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#define LETTER_COUNT 52 // A-Z at indices 0-25, a-z at indices 26-51
+
+/**
+ * Adds the number of occurrences of every ASCII letter in data[0..len) to counts.
+ * Dispatches once, at the first call, to the SSE2 kernel when the CPU has it
+ * (it measured faster than AVX2 in bench_hist), otherwise to the scalar one.
+ */
+void letter_hist_count(const unsigned char *data, size_t len, uint64_t counts[LETTER_COUNT]);
+
+/**
+ * Name of the kernel used by letter_hist_count ("sse2" or "scalar").
+ */
+const char* letter_hist_impl_name(void);
+
+/**
+ * Individual kernels, exposed for benchmarks. Same contract as letter_hist_count.
+ * letter_hist_avx2 may only be called when letter_hist_avx2_supported() is true.
+ */
+void letter_hist_scalar(const unsigned char *data, size_t len, uint64_t counts[LETTER_COUNT]);
+#if defined(__x86_64__) || defined(__i386__)
+void letter_hist_sse2(const unsigned char *data, size_t len, uint64_t counts[LETTER_COUNT]);
+void letter_hist_avx2(const unsigned char *data, size_t len, uint64_t counts[LETTER_COUNT]);
+bool letter_hist_avx2_supported(void);
+#endif
+
+#endif // LETTER_HIST_H
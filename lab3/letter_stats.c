@@ -0,0 +1,197 @@
+#define _GNU_SOURCE
+#include "letter_stats.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ERR(source) (perror(source), fprintf(stderr, "%s:%d\n", __FILE__, __LINE__), exit(EXIT_FAILURE))
+
+static const char *mode_names[] = { "mutex", "atomic", "local" };
+
+static void* aligned_calloc(size_t count, size_t size)
+{
+    void *ptr;
+    if(posix_memalign(&ptr, LS_CACHE_LINE, count * size) != 0)
+        return NULL;
+    memset(ptr, 0, count * size);
+    return ptr;
+}
+
+static inline void cpu_relax(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#endif
+}
+
+letter_stats* letter_stats_init(letter_stats_mode mode, int threadCount)
+{
+    letter_stats *stats = calloc(1, sizeof(letter_stats));
+    if(stats == NULL)
+        return NULL;
+    stats->mode = mode;
+    stats->threadCount = threadCount;
+    clock_gettime(CLOCK_MONOTONIC, &stats->start);
+    stats->local = aligned_calloc(threadCount, sizeof(letter_stats_local));
+    if(stats->local == NULL)
+    {
+        free(stats);
+        return NULL;
+    }
+
+    switch(mode)
+    {
+        case LETTER_STATS_MUTEX:
+            for(int i = 0; i < LETTER_COUNT; i++)
+            {
+                if(pthread_mutex_init(&stats->mutexes[i], NULL) != 0)
+                    ERR("Setup of letter mutexes");
+            }
+            break;
+        case LETTER_STATS_ATOMIC:
+            // każdy licznik na osobnej linii cache - wątki zliczające różne litery nie przeszkadzają sobie
+            stats->padded = aligned_calloc(LETTER_COUNT, sizeof(letter_stats_padded));
+            if(stats->padded == NULL)
+            {
+                free(stats->local);
+                free(stats);
+                return NULL;
+            }
+            break;
+        case LETTER_STATS_LOCAL:
+            break;
+    }
+    return stats;
+}
+
+void letter_stats_deinit(letter_stats *stats)
+{
+    if(stats->mode == LETTER_STATS_MUTEX)
+    {
+        for(int i = 0; i < LETTER_COUNT; i++)
+        {
+            if(pthread_mutex_destroy(&stats->mutexes[i]) != 0)
+                ERR("Mutex destroy");
+        }
+    }
+    free(stats->padded);
+    free(stats->local);
+    free(stats);
+}
+
+void letter_stats_add(letter_stats *stats, int thread, const uint64_t counts[LETTER_COUNT], uint64_t bytes)
+{
+    switch(stats->mode)
+    {
+        case LETTER_STATS_MUTEX:
+            for(int i = 0; i < LETTER_COUNT; i++)
+            {
+                if(counts[i] > 0)
+                {
+                    pthread_mutex_lock(&stats->mutexes[i]);
+                    // zapis atomowy, bo letter_stats_snapshot czyta bez blokady
+                    __atomic_store_n(&stats->counts[i], stats->counts[i] + counts[i], __ATOMIC_RELAXED);
+                    pthread_mutex_unlock(&stats->mutexes[i]);
+                }
+            }
+            break;
+        case LETTER_STATS_ATOMIC:
+            for(int i = 0; i < LETTER_COUNT; i++)
+            {
+                if(counts[i] > 0)
+                    __atomic_fetch_add(&stats->padded[i].value, counts[i], __ATOMIC_RELAXED);
+            }
+            break;
+        case LETTER_STATS_LOCAL:
+            break;
+    }
+
+    // jedyny piszący - zwykłe odczyty i zapisy atomowe, bez instrukcji z prefiksem lock
+    letter_stats_local *own = &stats->local[thread];
+    unsigned seq = own->seq;
+    __atomic_store_n(&own->seq, seq + 1, __ATOMIC_RELAXED); // nieparzysty - trwa zapis
+    __atomic_thread_fence(__ATOMIC_RELEASE);                 // zapis seq widoczny przed danymi
+    if(stats->mode == LETTER_STATS_LOCAL)
+    {
+        for(int i = 0; i < LETTER_COUNT; i++)
+            __atomic_store_n(&own->counts[i], own->counts[i] + counts[i], __ATOMIC_RELAXED);
+    }
+    __atomic_store_n(&own->files, own->files + 1, __ATOMIC_RELAXED);
+    __atomic_store_n(&own->bytes, own->bytes + bytes, __ATOMIC_RELAXED);
+    __atomic_store_n(&own->seq, seq + 2, __ATOMIC_RELEASE);
+}
+
+// Spójna kopia slotu jednego wątku; ponawiana, gdy wątek w tym czasie dodał plik
+static void read_local(const letter_stats_local *slot, bool withCounts, letter_stats_local *copy)
+{
+    for(;;)
+    {
+        unsigned seq = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+        if(seq & 1)
+        {
+            cpu_relax();
+            continue;
+        }
+        copy->files = __atomic_load_n(&slot->files, __ATOMIC_RELAXED);
+        copy->bytes = __atomic_load_n(&slot->bytes, __ATOMIC_RELAXED);
+        if(withCounts)
+        {
+            for(int i = 0; i < LETTER_COUNT; i++)
+                copy->counts[i] = __atomic_load_n(&slot->counts[i], __ATOMIC_RELAXED);
+        }
+        __atomic_thread_fence(__ATOMIC_ACQUIRE); // odczyty danych przed ponownym odczytem seq
+        if(__atomic_load_n(&slot->seq, __ATOMIC_RELAXED) == seq)
+            return;
+    }
+}
+
+void letter_stats_snapshot(letter_stats *stats, letter_snapshot *out)
+{
+    memset(out, 0, sizeof(letter_snapshot));
+    bool local = stats->mode == LETTER_STATS_LOCAL;
+    letter_stats_local copy;
+    for(int t = 0; t < stats->threadCount; t++)
+    {
+        read_local(&stats->local[t], local, &copy);
+        out->files += copy.files;
+        out->bytes += copy.bytes;
+        if(local)
+        {
+            for(int i = 0; i < LETTER_COUNT; i++)
+                out->counts[i] += copy.counts[i];
+        }
+    }
+
+    if(stats->mode == LETTER_STATS_MUTEX)
+    {
+        for(int i = 0; i < LETTER_COUNT; i++)
+            out->counts[i] = __atomic_load_n(&stats->counts[i], __ATOMIC_RELAXED);
+    }
+    else if(stats->mode == LETTER_STATS_ATOMIC)
+    {
+        for(int i = 0; i < LETTER_COUNT; i++)
+            out->counts[i] = __atomic_load_n(&stats->padded[i].value, __ATOMIC_RELAXED);
+    }
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    out->seconds = (now.tv_sec - stats->start.tv_sec) + (now.tv_nsec - stats->start.tv_nsec) / 1e9;
+}
+
+bool letter_stats_parse_mode(const char *name, letter_stats_mode *mode)
+{
+    for(size_t i = 0; i < sizeof(mode_names) / sizeof(mode_names[0]); i++)
+    {
+        if(strcmp(name, mode_names[i]) == 0)
+        {
+            *mode = (letter_stats_mode)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* letter_stats_mode_name(letter_stats_mode mode)
+{
+    return mode_names[mode];
+}
@@ -0,0 +1,86 @@
+#ifndef LETTER_STATS_H
+#define LETTER_STATS_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+#include "letter_hist.h"
+
+#define LS_CACHE_LINE 64
+
+typedef enum letter_stats_mode {
+    LETTER_STATS_MUTEX,  // One mutex per letter, locked for every non-zero count of a file
+    LETTER_STATS_ATOMIC, // Relaxed fetch-add on counters padded to a cache line each
+    LETTER_STATS_LOCAL   // Private per-thread histograms, summed only by letter_stats_snapshot
+} letter_stats_mode;
+
+typedef struct letter_stats_padded {
+    uint64_t value;
+} __attribute__((aligned(LS_CACHE_LINE))) letter_stats_padded;
+
+/*
+ * Per-thread progress, written only by its thread under a seqlock: `seq` is
+ * odd while an update is in progress. Readers retry instead of blocking the writer.
+ */
+typedef struct letter_stats_local {
+    unsigned seq;
+    uint64_t files;
+    uint64_t bytes;
+    uint64_t counts[LETTER_COUNT]; // LETTER_STATS_LOCAL only
+} __attribute__((aligned(LS_CACHE_LINE))) letter_stats_local;
+
+typedef struct letter_snapshot {
+    uint64_t counts[LETTER_COUNT];
+    uint64_t files;
+    uint64_t bytes;
+    double seconds; // since letter_stats_init
+} letter_snapshot;
+
+typedef struct letter_stats {
+    letter_stats_mode mode;
+    int threadCount;
+    uint64_t counts[LETTER_COUNT];           // LETTER_STATS_MUTEX totals
+    pthread_mutex_t mutexes[LETTER_COUNT];   // LETTER_STATS_MUTEX, one per letter
+    letter_stats_padded *padded;             // LETTER_STATS_ATOMIC, LETTER_COUNT counters
+    letter_stats_local *local;               // one slot per thread, in every mode
+    struct timespec start;
+} letter_stats;
+
+/**
+ * Creates letter totals shared by `threadCount` threads, numbered 0..threadCount-1.
+ * Returns a pointer to the structure, or NULL on failure.
+ */
+letter_stats* letter_stats_init(letter_stats_mode mode, int threadCount);
+
+/**
+ * Destroys the structure and frees all associated resources.
+ */
+void letter_stats_deinit(letter_stats *stats);
+
+/**
+ * Adds the counts and size of one file to the totals. `thread` is the caller's
+ * number; two threads must never pass the same number.
+ */
+void letter_stats_add(letter_stats *stats, int thread, const uint64_t counts[LETTER_COUNT], uint64_t bytes);
+
+/**
+ * Fills out with the current totals without taking any lock. Files and bytes
+ * always come from the per-thread seqlocks. In LETTER_STATS_LOCAL the letters
+ * do too, so every file is either fully in the snapshot or not at all; in the
+ * other modes the shared counters are read one by one and may contain part of
+ * the files being added at that moment.
+ */
+void letter_stats_snapshot(letter_stats *stats, letter_snapshot *out);
+
+/**
+ * Parses "mutex", "atomic" or "local". Returns false on unknown names.
+ */
+bool letter_stats_parse_mode(const char *name, letter_stats_mode *mode);
+
+/**
+ * Returns the name of the mode as accepted by letter_stats_parse_mode.
+ */
+const char* letter_stats_mode_name(letter_stats_mode mode);
+
+#endif // LETTER_STATS_H
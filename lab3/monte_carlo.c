@@ -0,0 +1,272 @@
+#include "monte_carlo.h"
+#include <pthread.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define MC_X86 1
+#endif
+
+// Bity 32-bitowej połówki jako mantysa liczby z [1, 2); odjęcie 1 daje współrzędną z [0, 1)
+#define ONE_BITS 0x3ff0000000000000ull
+
+typedef uint64_t (*mc_kernel)(mc_rng *rng, uint64_t samples);
+typedef void (*mc_fill_kernel)(mc_rng *rng, uint64_t *out, size_t count);
+
+static mc_kernel selectedKernel;
+static mc_fill_kernel selectedFill;
+static const char *selectedName;
+static pthread_once_t selectOnce = PTHREAD_ONCE_INIT;
+
+static inline uint64_t rotl(uint64_t x, int k)
+{
+    return (x << k) | (x >> (64 - k));
+}
+
+static uint64_t splitmix64(uint64_t *state)
+{
+    uint64_t z = (*state += 0x9e3779b97f4a7c15ull);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return z ^ (z >> 31);
+}
+
+// Jeden krok xoshiro256** dla toru l
+static inline uint64_t next_lane(uint64_t s[4][MC_LANES], int l)
+{
+    uint64_t result = rotl(s[1][l] * 5, 7) * 9;
+    uint64_t t = s[1][l] << 17;
+    s[2][l] ^= s[0][l];
+    s[3][l] ^= s[1][l];
+    s[1][l] ^= s[2][l];
+    s[0][l] ^= s[3][l];
+    s[2][l] ^= t;
+    s[3][l] = rotl(s[3][l], 45);
+    return result;
+}
+
+// Skok o 2^128 wyjść toru 0 (stałe z referencyjnej implementacji xoshiro256**)
+static void jump(uint64_t s[4][MC_LANES])
+{
+    static const uint64_t JUMP[] = { 0x180ec6d33cfd0aba, 0xd5a61266f0c9392c, 0xa9582618e03fc9aa, 0x39abdc4529b1661c };
+    uint64_t t[4] = { 0, 0, 0, 0 };
+    for(int i = 0; i < 4; i++)
+    {
+        for(int b = 0; b < 64; b++)
+        {
+            if(JUMP[i] & (1ull << b))
+                for(int j = 0; j < 4; j++)
+                    t[j] ^= s[j][0];
+            next_lane(s, 0);
+        }
+    }
+    for(int j = 0; j < 4; j++)
+        s[j][0] = t[j];
+}
+
+void mc_rng_seed(mc_rng *rng, uint64_t seed, uint64_t stream)
+{
+    // stan bazowy w torze 0; strumień zaczyna się po stream * MC_LANES skokach, każdy tor o skok dalej
+    for(int j = 0; j < 4; j++)
+        rng->s[j][0] = splitmix64(&seed);
+    for(uint64_t i = 0; i < stream * MC_LANES; i++)
+        jump(rng->s);
+    for(int l = MC_LANES - 1; l >= 0; l--)
+    {
+        uint64_t base[4];
+        for(int j = 0; j < 4; j++)
+            base[j] = rng->s[j][0];
+        for(int i = 0; i < l; i++)
+            jump(rng->s);
+        for(int j = 0; j < 4; j++)
+        {
+            rng->s[j][l] = rng->s[j][0];
+            rng->s[j][0] = base[j];
+        }
+    }
+}
+
+static inline uint64_t inside_point(uint64_t r)
+{
+    uint64_t xBits = ((r >> 32) << 20) | ONE_BITS;
+    uint64_t yBits = ((r & 0xffffffffull) << 20) | ONE_BITS;
+    double x, y;
+    memcpy(&x, &xBits, sizeof(x));
+    memcpy(&y, &yBits, sizeof(y));
+    x -= 1.0;
+    y -= 1.0;
+    return x * x + y * y < 1.0;
+}
+
+uint64_t mc_next(mc_rng *rng)
+{
+    return next_lane(rng->s, 0);
+}
+
+static void fill_scalar(mc_rng *rng, uint64_t *out, size_t count)
+{
+    size_t i = 0;
+    for(; i + MC_LANES <= count; i += MC_LANES)
+        for(int l = 0; l < MC_LANES; l++)
+            out[i + l] = next_lane(rng->s, l);
+    for(int l = 0; i < count; i++, l++)
+        out[i] = next_lane(rng->s, l);
+}
+
+// Reszta próbek (mniej niż MC_LANES) z kolejnych torów - tak samo w każdym jądrze
+static uint64_t count_tail(mc_rng *rng, uint64_t samples)
+{
+    uint64_t inside = 0;
+    for(uint64_t l = 0; l < samples; l++)
+        inside += inside_point(next_lane(rng->s, l));
+    return inside;
+}
+
+uint64_t mc_count_inside_scalar(mc_rng *rng, uint64_t samples)
+{
+    // tory po kolei, każdy w zmiennych lokalnych - suma nie zależy od kolejności,
+    // więc wynik i stan końcowy są takie jak w jądrze wektorowym
+    uint64_t inside = 0;
+    uint64_t full = samples / MC_LANES;
+    for(int l = 0; l < MC_LANES; l++)
+    {
+        uint64_t s0 = rng->s[0][l], s1 = rng->s[1][l], s2 = rng->s[2][l], s3 = rng->s[3][l];
+        for(uint64_t i = 0; i < full; i++)
+        {
+            uint64_t r = rotl(s1 * 5, 7) * 9;
+            uint64_t t = s1 << 17;
+            s2 ^= s0;
+            s3 ^= s1;
+            s1 ^= s2;
+            s0 ^= s3;
+            s2 ^= t;
+            s3 = rotl(s3, 45);
+            inside += inside_point(r);
+        }
+        rng->s[0][l] = s0;
+        rng->s[1][l] = s1;
+        rng->s[2][l] = s2;
+        rng->s[3][l] = s3;
+    }
+    return inside + count_tail(rng, samples % MC_LANES);
+}
+
+#ifdef MC_X86
+
+#pragma GCC push_options
+#pragma GCC target("avx2")
+
+typedef uint64_t mc_vec __attribute__((vector_size(MC_LANES * sizeof(uint64_t))));
+typedef double mc_dvec __attribute__((vector_size(MC_LANES * sizeof(double))));
+
+#define ROTL_VEC(x, k) (((x) << (k)) | ((x) >> (64 - (k))))
+
+// xoshiro256** na czterech torach; mnożenia przez 5 i 9 jako przesunięcia, AVX2 nie ma mnożenia 64-bitowego
+#define NEXT_VEC(r, s0, s1, s2, s3)        \
+    do {                                   \
+        mc_vec x_ = (s1) + ((s1) << 2);    \
+        x_ = ROTL_VEC(x_, 7);              \
+        (r) = x_ + (x_ << 3);              \
+        mc_vec t_ = (s1) << 17;            \
+        (s2) ^= (s0);                      \
+        (s3) ^= (s1);                      \
+        (s1) ^= (s2);                      \
+        (s0) ^= (s3);                      \
+        (s2) ^= t_;                        \
+        (s3) = ROTL_VEC((s3), 45);         \
+    } while(0)
+
+static void fill_avx2(mc_rng *rng, uint64_t *out, size_t count)
+{
+    mc_vec s0, s1, s2, s3, r;
+    memcpy(&s0, rng->s[0], sizeof(mc_vec));
+    memcpy(&s1, rng->s[1], sizeof(mc_vec));
+    memcpy(&s2, rng->s[2], sizeof(mc_vec));
+    memcpy(&s3, rng->s[3], sizeof(mc_vec));
+    size_t i = 0;
+    for(; i + MC_LANES <= count; i += MC_LANES)
+    {
+        NEXT_VEC(r, s0, s1, s2, s3);
+        memcpy(out + i, &r, sizeof(r));
+    }
+    memcpy(rng->s[0], &s0, sizeof(mc_vec));
+    memcpy(rng->s[1], &s1, sizeof(mc_vec));
+    memcpy(rng->s[2], &s2, sizeof(mc_vec));
+    memcpy(rng->s[3], &s3, sizeof(mc_vec));
+    for(int l = 0; i < count; i++, l++)
+        out[i] = next_lane(rng->s, l);
+}
+
+uint64_t mc_count_inside_avx2(mc_rng *rng, uint64_t samples)
+{
+    mc_vec s0, s1, s2, s3, r;
+    memcpy(&s0, rng->s[0], sizeof(mc_vec));
+    memcpy(&s1, rng->s[1], sizeof(mc_vec));
+    memcpy(&s2, rng->s[2], sizeof(mc_vec));
+    memcpy(&s3, rng->s[3], sizeof(mc_vec));
+    const mc_vec one = { ONE_BITS, ONE_BITS, ONE_BITS, ONE_BITS };
+    const mc_dvec unit = { 1.0, 1.0, 1.0, 1.0 };
+    mc_vec count = { 0, 0, 0, 0 };
+
+    uint64_t full = samples / MC_LANES;
+    for(uint64_t i = 0; i < full; i++)
+    {
+        NEXT_VEC(r, s0, s1, s2, s3);
+        mc_vec xBits = ((r >> 32) << 20) | one;
+        mc_vec yBits = ((r << 32) >> 12) | one;
+        mc_dvec px = (mc_dvec)xBits - unit;
+        mc_dvec py = (mc_dvec)yBits - unit;
+        count -= (mc_vec)(px * px + py * py < unit); // -1 w torach wewnątrz koła
+    }
+
+    memcpy(rng->s[0], &s0, sizeof(mc_vec));
+    memcpy(rng->s[1], &s1, sizeof(mc_vec));
+    memcpy(rng->s[2], &s2, sizeof(mc_vec));
+    memcpy(rng->s[3], &s3, sizeof(mc_vec));
+    uint64_t inside = 0;
+    for(int l = 0; l < MC_LANES; l++)
+        inside += count[l];
+    return inside + count_tail(rng, samples % MC_LANES);
+}
+
+#pragma GCC pop_options
+
+bool mc_avx2_supported(void)
+{
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+}
+
+#endif // MC_X86
+
+static void select_kernel(void)
+{
+    selectedKernel = mc_count_inside_scalar;
+    selectedFill = fill_scalar;
+    selectedName = "scalar";
+#ifdef MC_X86
+    if(mc_avx2_supported())
+    {
+        selectedKernel = mc_count_inside_avx2;
+        selectedFill = fill_avx2;
+        selectedName = "avx2";
+    }
+#endif
+}
+
+uint64_t mc_count_inside(mc_rng *rng, uint64_t samples)
+{
+    pthread_once(&selectOnce, select_kernel);
+    return selectedKernel(rng, samples);
+}
+
+void mc_fill(mc_rng *rng, uint64_t *out, size_t count)
+{
+    pthread_once(&selectOnce, select_kernel);
+    selectedFill(rng, out, count);
+}
+
+const char* mc_impl_name(void)
+{
+    pthread_once(&selectOnce, select_kernel);
+    return selectedName;
+}
@@ -0,0 +1,65 @@
+#ifndef MONTE_CARLO_H
+#define MONTE_CARLO_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define MC_LANES 4 // independent xoshiro256** streams, one per 64-bit vector lane
+
+/*
+ * xoshiro256** generator with MC_LANES interleaved states: word j of lane l is
+ * s[j][l]. Lanes and streams are separated by the generator's jump function,
+ * so they do not overlap for 2^128 outputs each.
+ */
+typedef struct mc_rng {
+    uint64_t s[4][MC_LANES];
+} mc_rng;
+
+/**
+ * Seeds stream `stream` (e.g. the thread index) derived from `seed`.
+ * Equal seed and stream give the same sequence.
+ */
+void mc_rng_seed(mc_rng *rng, uint64_t seed, uint64_t stream);
+
+/**
+ * Next output of lane 0; the other lanes do not move.
+ */
+uint64_t mc_next(mc_rng *rng);
+
+/**
+ * Fills out[0..count) with generator outputs, out[i] taken from lane i % MC_LANES.
+ * Uses the AVX2 kernel when available; the output does not depend on the kernel.
+ */
+void mc_fill(mc_rng *rng, uint64_t *out, size_t count);
+
+/**
+ * Counts how many of `samples` uniform points in the unit square fall inside
+ * the quarter circle x^2 + y^2 < 1. Every point takes one 64-bit output split
+ * into two 32-bit coordinates, turned into doubles by bit manipulation; there
+ * is no sqrt and no integer-to-double conversion. Lanes advance together, so
+ * every kernel gives the same count for the same generator state.
+ * Uses the AVX2 kernel when the CPU supports it.
+ */
+uint64_t mc_count_inside(mc_rng *rng, uint64_t samples);
+
+/**
+ * The same computation with the portable kernel.
+ */
+uint64_t mc_count_inside_scalar(mc_rng *rng, uint64_t samples);
+
+#if defined(__x86_64__) || defined(__i386__)
+/**
+ * The same computation with the AVX2 kernel; the CPU must support AVX2.
+ */
+uint64_t mc_count_inside_avx2(mc_rng *rng, uint64_t samples);
+
+bool mc_avx2_supported(void);
+#endif
+
+/**
+ * Name of the kernel chosen by mc_count_inside ("avx2" or "scalar").
+ */
+const char* mc_impl_name(void);
+
+#endif // MONTE_CARLO_H
@@ -0,0 +1,103 @@
+#include "path_arena.h"
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define HEADER_SIZE ((sizeof(path_chunk) + PA_CACHE_LINE - 1) & ~(size_t)(PA_CACHE_LINE - 1))
+
+path_arena* path_arena_init(void)
+{
+    path_arena *arena;
+    if(posix_memalign((void **)&arena, PA_CACHE_LINE, sizeof(path_arena)) != 0)
+        return NULL;
+    memset(arena, 0, sizeof(path_arena));
+    return arena;
+}
+
+void path_arena_deinit(path_arena *arena)
+{
+    if(arena == NULL)
+        return;
+    while(arena->all != NULL)
+    {
+        path_chunk *next = arena->all->nextAll;
+        free(arena->all);
+        arena->all = next;
+    }
+    free(arena);
+}
+
+// Ostatni napis chunka zwolniony - chunk wraca do właściciela
+static void recycle(path_chunk *chunk)
+{
+    path_arena *arena = chunk->arena;
+    chunk->next = __atomic_load_n(&arena->recycled, __ATOMIC_RELAXED);
+    while(!__atomic_compare_exchange_n(&arena->recycled, &chunk->next, chunk, true, __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+        ;
+}
+
+// Właściciel kończy z bieżącym chunkiem: dopisuje liczbę wydanych napisów
+static void retire(path_arena *arena)
+{
+    path_chunk *chunk = arena->current;
+    if(chunk != NULL && __atomic_add_fetch(&chunk->pending, arena->allocated, __ATOMIC_ACQ_REL) == 0)
+    {
+        // wszystkie napisy już zwolnione - od razu na listę właściciela
+        chunk->next = arena->spare;
+        arena->spare = chunk;
+    }
+    arena->current = NULL;
+}
+
+static path_chunk* next_chunk(path_arena *arena)
+{
+    // właściciel zabiera cały stos naraz - bez zdejmowania pojedynczych węzłów nie ma problemu ABA
+    if(arena->spare == NULL)
+        arena->spare = __atomic_exchange_n(&arena->recycled, NULL, __ATOMIC_ACQUIRE);
+
+    path_chunk *chunk = arena->spare;
+    if(chunk != NULL)
+    {
+        arena->spare = chunk->next;
+        arena->reused++;
+        return chunk; // pending wróciło do 0
+    }
+
+    if(posix_memalign((void **)&chunk, PA_CHUNK_SIZE, PA_CHUNK_SIZE) != 0)
+        return NULL;
+    chunk->arena = arena;
+    chunk->pending = 0;
+    chunk->nextAll = arena->all;
+    arena->all = chunk;
+    arena->chunks++;
+    return chunk;
+}
+
+char* path_arena_strdup(path_arena *arena, const char *path)
+{
+    size_t size = strlen(path) + 1;
+    if(size > PA_CHUNK_SIZE - HEADER_SIZE)
+        return NULL;
+
+    if(arena->current == NULL || arena->used + size > PA_CHUNK_SIZE)
+    {
+        retire(arena);
+        if((arena->current = next_chunk(arena)) == NULL)
+            return NULL;
+        arena->used = HEADER_SIZE;
+        arena->allocated = 0;
+    }
+
+    char *copy = (char *)arena->current + arena->used;
+    memcpy(copy, path, size);
+    arena->used += size;
+    arena->allocated++;
+    return copy;
+}
+
+void path_arena_release(char *path)
+{
+    path_chunk *chunk = (path_chunk *)((uintptr_t)path & ~(uintptr_t)(PA_CHUNK_SIZE - 1));
+    if(__atomic_sub_fetch(&chunk->pending, 1, __ATOMIC_ACQ_REL) == 0)
+        recycle(chunk);
+}
@@ -0,0 +1,60 @@
+#ifndef PATH_ARENA_H
+#define PATH_ARENA_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define PA_CACHE_LINE 64
+#define PA_CHUNK_SIZE (64 * 1024) // Chunks are aligned to their size, so a path finds its chunk by masking
+
+/*
+ * Header at the start of every chunk. `pending` is 0 while the owner fills the
+ * chunk and drops by one for every released path; when the owner moves on it
+ * adds the number of paths it handed out, so the chunk is free exactly when
+ * the counter returns to 0. Owner allocations therefore need no atomics.
+ */
+typedef struct path_chunk {
+    struct path_arena *arena;
+    struct path_chunk *next;    // Link on the recycled list
+    struct path_chunk *nextAll; // Every chunk of the arena, for path_arena_deinit
+    long pending __attribute__((aligned(PA_CACHE_LINE)));
+} path_chunk;
+
+/*
+ * Bump allocator for path strings handed from one producer thread to any
+ * number of consumers. Only the owner allocates; any thread may release.
+ */
+typedef struct path_arena {
+    path_chunk *current;
+    size_t used;          // Bytes taken in `current`, header included
+    long allocated;       // Paths handed out from `current`
+    path_chunk *spare;    // Recycled chunks owned by the allocating thread
+    path_chunk *all;
+    uint64_t chunks;      // Chunks obtained from the system
+    uint64_t reused;      // Chunks taken back from the recycled list
+    path_chunk *recycled __attribute__((aligned(PA_CACHE_LINE))); // Treiber stack pushed by releasing threads
+} path_arena;
+
+/**
+ * Creates an empty arena. Returns NULL on allocation failure.
+ */
+path_arena* path_arena_init(void);
+
+/**
+ * Frees every chunk, including paths that were never released.
+ * No other thread may use the arena or its paths any more.
+ */
+void path_arena_deinit(path_arena *arena);
+
+/**
+ * Copies `path` into the arena; only the owning thread may call it.
+ * Returns NULL on allocation failure or when the path does not fit in a chunk.
+ */
+char* path_arena_strdup(path_arena *arena, const char *path);
+
+/**
+ * Releases a path returned by path_arena_strdup; safe from any thread.
+ */
+void path_arena_release(char *path);
+
+#endif // PATH_ARENA_H
@@ -0,0 +1,351 @@
+#include "pipeline.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+static pipeline_ring* ring_init(size_t capacity)
+{
+    pipeline_ring *ring = calloc(1, sizeof(pipeline_ring));
+    if(ring == NULL)
+        return NULL;
+    ring->capacity = capacity;
+    ring->slots = malloc(sizeof(pipeline_slot) * capacity);
+    if(ring->slots == NULL)
+    {
+        free(ring);
+        return NULL;
+    }
+    pthread_mutex_init(&ring->mutex, NULL);
+    pthread_cond_init(&ring->notEmpty, NULL);
+    pthread_cond_init(&ring->notFull, NULL);
+    return ring;
+}
+
+static void ring_deinit(pipeline_ring *ring)
+{
+    if(ring == NULL)
+        return;
+    pthread_cond_destroy(&ring->notFull);
+    pthread_cond_destroy(&ring->notEmpty);
+    pthread_mutex_destroy(&ring->mutex);
+    free(ring->slots);
+    free(ring);
+}
+
+// Wstawia element, czekając na miejsce; false po zamknięciu pierścienia
+static bool ring_push(pipeline_ring *ring, void *item)
+{
+    pthread_mutex_lock(&ring->mutex);
+    if(ring->count == ring->capacity && !ring->closed)
+    {
+        // przeciwciśnienie: wątek przed pełnym pierścieniem śpi, aż etap za nim coś pobierze
+        uint64_t start = now_ns();
+        while(ring->count == ring->capacity && !ring->closed)
+            pthread_cond_wait(&ring->notFull, &ring->mutex);
+        ring->fullWaits++;
+        ring->fullWaitNs += now_ns() - start;
+    }
+    if(ring->closed)
+    {
+        pthread_mutex_unlock(&ring->mutex);
+        return false;
+    }
+    pipeline_slot *slot = &ring->slots[ring->head];
+    slot->item = item;
+    slot->seq = ring->nextSeq++;
+    slot->enqueuedNs = now_ns();
+    ring->head = (ring->head + 1) % ring->capacity;
+    ring->count++;
+    pthread_cond_signal(&ring->notEmpty);
+    pthread_mutex_unlock(&ring->mutex);
+    return true;
+}
+
+// Pobiera element, czekając na niego; false, gdy pierścień jest zamknięty i pusty
+static bool ring_pop(pipeline_ring *ring, pipeline_slot *out)
+{
+    pthread_mutex_lock(&ring->mutex);
+    if(ring->count == 0 && !ring->closed)
+    {
+        uint64_t start = now_ns();
+        while(ring->count == 0 && !ring->closed)
+            pthread_cond_wait(&ring->notEmpty, &ring->mutex);
+        ring->emptyWaits++;
+        ring->emptyWaitNs += now_ns() - start;
+    }
+    if(ring->count == 0)
+    {
+        pthread_mutex_unlock(&ring->mutex);
+        return false;
+    }
+    ring->depthSum += ring->count;
+    if(ring->count > ring->depthMax)
+        ring->depthMax = ring->count;
+    *out = ring->slots[ring->tail];
+    ring->tail = (ring->tail + 1) % ring->capacity;
+    ring->count--;
+    ring->queueNs += now_ns() - out->enqueuedNs;
+    pthread_cond_signal(&ring->notFull);
+    pthread_mutex_unlock(&ring->mutex);
+    return true;
+}
+
+// Pozostałe elementy można jeszcze pobrać; budzi wszystkich czekających
+static void ring_close(pipeline_ring *ring)
+{
+    pthread_mutex_lock(&ring->mutex);
+    ring->closed = true;
+    pthread_cond_broadcast(&ring->notEmpty);
+    pthread_cond_broadcast(&ring->notFull);
+    pthread_mutex_unlock(&ring->mutex);
+}
+
+static void stat_max(uint64_t *max, uint64_t value)
+{
+    uint64_t current = __atomic_load_n(max, __ATOMIC_RELAXED);
+    while(value > current && !__atomic_compare_exchange_n(max, &current, value, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+        ;
+}
+
+static void* stage_worker(void *arg)
+{
+    pipeline_stage *stage = arg;
+    pipeline_slot slot;
+    while(ring_pop(stage->input, &slot))
+    {
+        uint64_t start = now_ns();
+        void *result = stage->fn(slot.item, stage->ctx);
+        uint64_t busy = now_ns() - start;
+        __atomic_add_fetch(&stage->items, 1, __ATOMIC_RELAXED);
+        __atomic_add_fetch(&stage->busyNs, busy, __ATOMIC_RELAXED);
+        stat_max(&stage->maxBusyNs, busy);
+        if(result == NULL)
+            __atomic_add_fetch(&stage->dropped, 1, __ATOMIC_RELAXED);
+
+        if(stage->order == PIPELINE_ORDERED)
+        {
+            // wejście jest FIFO, więc wcześniejsze elementy są już u innych pracowników - czekanie na kolejkę kończy się zawsze
+            pthread_mutex_lock(&stage->mxStage);
+            if(stage->nextEmit != slot.seq)
+            {
+                uint64_t waitStart = now_ns();
+                while(stage->nextEmit != slot.seq)
+                    pthread_cond_wait(&stage->turn, &stage->mxStage);
+                stage->orderWaitNs += now_ns() - waitStart;
+            }
+            // odrzucony element też zajmuje swoją kolejkę; numery w pierścieniu wyjściowym pozostają ciągłe
+            if(result != NULL)
+                ring_push(stage->output, result);
+            stage->nextEmit++;
+            pthread_cond_broadcast(&stage->turn);
+            pthread_mutex_unlock(&stage->mxStage);
+        }
+        else if(result != NULL)
+            ring_push(stage->output, result);
+    }
+
+    pthread_mutex_lock(&stage->mxStage);
+    bool last = --stage->running == 0;
+    pthread_mutex_unlock(&stage->mxStage);
+    if(last)
+        ring_close(stage->output);
+    return NULL;
+}
+
+pipeline* pipeline_init(size_t outputCapacity)
+{
+    pipeline *p = calloc(1, sizeof(pipeline));
+    if(p == NULL)
+        return NULL;
+    p->outputCapacity = outputCapacity == 0 ? PIPELINE_DEFAULT_CAPACITY : outputCapacity;
+    return p;
+}
+
+int pipeline_add_stage(pipeline *p, const char *name, pipeline_fn fn, void *ctx, int workers, size_t capacity,
+                       pipeline_order order)
+{
+    if(p->started || p->stageCount == PIPELINE_MAX_STAGES || fn == NULL || workers < 1)
+        return -1;
+    pipeline_stage *stage = &p->stages[p->stageCount];
+    memset(stage, 0, sizeof(*stage));
+    snprintf(stage->name, sizeof(stage->name), "%s", name);
+    stage->fn = fn;
+    stage->ctx = ctx;
+    stage->workers = workers;
+    stage->order = order;
+    stage->capacity = capacity == 0 ? PIPELINE_DEFAULT_CAPACITY : capacity;
+    return p->stageCount++;
+}
+
+// Zwalnia pierścienie i zasoby etapów; wątki muszą być już zakończone
+static void release_stages(pipeline *p)
+{
+    for(int s = 0; s < p->stageCount; s++)
+    {
+        pipeline_stage *stage = &p->stages[s];
+        if(stage->threads != NULL)
+        {
+            pthread_cond_destroy(&stage->turn);
+            pthread_mutex_destroy(&stage->mxStage);
+            free(stage->threads);
+            stage->threads = NULL;
+        }
+    }
+    for(int s = 0; s <= p->stageCount; s++)
+    {
+        ring_deinit(p->rings[s]);
+        p->rings[s] = NULL;
+    }
+}
+
+bool pipeline_start(pipeline *p)
+{
+    if(p->started || p->stageCount == 0)
+        return false;
+    for(int s = 0; s <= p->stageCount; s++)
+    {
+        p->rings[s] = ring_init(s < p->stageCount ? p->stages[s].capacity : p->outputCapacity);
+        if(p->rings[s] == NULL)
+        {
+            release_stages(p);
+            return false;
+        }
+    }
+    for(int s = 0; s < p->stageCount; s++)
+    {
+        pipeline_stage *stage = &p->stages[s];
+        stage->input = p->rings[s];
+        stage->output = p->rings[s + 1];
+        stage->running = stage->workers;
+        stage->nextEmit = 0;
+        stage->threads = malloc(sizeof(pthread_t) * stage->workers);
+        if(stage->threads == NULL)
+        {
+            release_stages(p);
+            return false;
+        }
+        pthread_mutex_init(&stage->mxStage, NULL);
+        pthread_cond_init(&stage->turn, NULL);
+    }
+    for(int s = 0; s < p->stageCount; s++)
+    {
+        pipeline_stage *stage = &p->stages[s];
+        for(int w = 0; w < stage->workers; w++)
+        {
+            if(pthread_create(&stage->threads[w], NULL, stage_worker, stage) == 0)
+                continue;
+            // działający pracownicy kończą kaskadowo po zamknięciu wejścia; etap s ma tylko w z nich
+            pthread_mutex_lock(&stage->mxStage);
+            stage->running = w;
+            pthread_mutex_unlock(&stage->mxStage);
+            ring_close(p->rings[0]);
+            for(int t = 0; t <= s; t++)
+                for(int j = 0; j < (t == s ? w : p->stages[t].workers); j++)
+                    pthread_join(p->stages[t].threads[j], NULL);
+            release_stages(p);
+            return false;
+        }
+    }
+    p->started = true;
+    return true;
+}
+
+bool pipeline_submit(pipeline *p, void *item)
+{
+    if(!p->started)
+        return false;
+    return ring_push(p->rings[0], item);
+}
+
+void pipeline_close(pipeline *p)
+{
+    if(p->started)
+        ring_close(p->rings[0]);
+}
+
+void* pipeline_next(pipeline *p)
+{
+    pipeline_slot slot;
+    if(!p->started || !ring_pop(p->rings[p->stageCount], &slot))
+        return NULL;
+    return slot.item;
+}
+
+void pipeline_deinit(pipeline *p)
+{
+    if(p->started)
+    {
+        pipeline_close(p);
+        // niepobrane wyniki blokowałyby ostatni etap na pełnym pierścieniu
+        while(pipeline_next(p) != NULL)
+            ;
+        for(int s = 0; s < p->stageCount; s++)
+            for(int w = 0; w < p->stages[s].workers; w++)
+                pthread_join(p->stages[s].threads[w], NULL);
+        release_stages(p);
+    }
+    free(p);
+}
+
+bool pipeline_get_stats(pipeline *p, int stage, pipeline_stage_stats *stats)
+{
+    memset(stats, 0, sizeof(*stats));
+    if(stage < 0 || stage >= p->stageCount)
+        return false;
+    pipeline_stage *st = &p->stages[stage];
+    stats->items = __atomic_load_n(&st->items, __ATOMIC_RELAXED);
+    stats->dropped = __atomic_load_n(&st->dropped, __ATOMIC_RELAXED);
+    stats->busyNs = __atomic_load_n(&st->busyNs, __ATOMIC_RELAXED);
+    stats->maxBusyNs = __atomic_load_n(&st->maxBusyNs, __ATOMIC_RELAXED);
+    if(!p->started)
+        return true;
+    pthread_mutex_lock(&st->mxStage);
+    stats->orderWaitNs = st->orderWaitNs;
+    pthread_mutex_unlock(&st->mxStage);
+    pipeline_ring *ring = st->input;
+    pthread_mutex_lock(&ring->mutex);
+    stats->queueNs = ring->queueNs;
+    stats->depthSum = ring->depthSum;
+    stats->depthMax = ring->depthMax;
+    stats->fullWaits = ring->fullWaits;
+    stats->fullWaitNs = ring->fullWaitNs;
+    stats->emptyWaits = ring->emptyWaits;
+    stats->emptyWaitNs = ring->emptyWaitNs;
+    pthread_mutex_unlock(&ring->mutex);
+    return true;
+}
+
+void pipeline_print_stats(pipeline *p, FILE *out)
+{
+    // obsługa i kolejka: średnie na element; wstrzymania: ile razy i jak długo etap przed nim czekał na miejsce
+    // szerokości nagłówków z polskimi znakami powiększone o dodatkowe bajty UTF-8
+    fprintf(out, "%-12s %6s %9s %9s %12s %11s %11s %9s %5s %10s %10s\n", "etap", "wątki", "elementy", "odrzucone",
+            "obsługa[us]", "maks.[us]", "kolejka[us]", "głęb.", "maks.", "wstrzym.[s]", "bezczyn.[s]");
+    int slowest = -1;
+    double slowestPerWorker = 0.0;
+    for(int s = 0; s < p->stageCount; s++)
+    {
+        pipeline_stage_stats st;
+        pipeline_get_stats(p, s, &st);
+        uint64_t n = st.items > 0 ? st.items : 1;
+        fprintf(out, "%-12s %5d %9lu %9lu %11.1f %11.1f %11.1f %7.2f %5lu %10.3f %10.3f\n", p->stages[s].name,
+                p->stages[s].workers, (unsigned long)st.items, (unsigned long)st.dropped, st.busyNs / 1e3 / n,
+                st.maxBusyNs / 1e3, st.queueNs / 1e3 / n, (double)st.depthSum / n, (unsigned long)st.depthMax,
+                st.fullWaitNs / 1e9, st.emptyWaitNs / 1e9);
+        double perWorker = (double)st.busyNs / p->stages[s].workers;
+        if(slowest == -1 || perWorker > slowestPerWorker)
+        {
+            slowest = s;
+            slowestPerWorker = perWorker;
+        }
+    }
+    if(slowest != -1)
+        fprintf(out, "Wąskie gardło: %s (%.3f s obsługi na wątek)\n", p->stages[slowest].name, slowestPerWorker / 1e9);
+}
@@ -0,0 +1,164 @@
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define PIPELINE_MAX_STAGES 16
+#define PIPELINE_DEFAULT_CAPACITY 16
+
+/**
+ * Stage callback: processes one item and returns the item handed to the next
+ * stage (the same pointer or a different one). NULL drops the item; the
+ * callback is then responsible for releasing it.
+ */
+typedef void* (*pipeline_fn)(void *item, void *ctx);
+
+typedef enum pipeline_order {
+    PIPELINE_UNORDERED, // Results go downstream as soon as a worker finishes them
+    PIPELINE_ORDERED    // Results go downstream in the order the stage received the items
+} pipeline_order;
+
+/*
+ * Counters of one stage. The queue fields describe its input ring: depth is
+ * sampled at every dequeue, queueNs is the time from enqueue to dequeue and
+ * fullWaits are upstream threads blocked by backpressure.
+ */
+typedef struct pipeline_stage_stats {
+    uint64_t items;       // Items taken by the callback
+    uint64_t dropped;     // ... for which it returned NULL
+    uint64_t busyNs;      // Total time in the callback
+    uint64_t maxBusyNs;   // Longest single call
+    uint64_t orderWaitNs; // Time finished items waited for their turn (PIPELINE_ORDERED)
+    uint64_t queueNs;     // Total time items spent in the input ring
+    uint64_t depthSum;    // Sum of the sampled input depths
+    uint64_t depthMax;
+    uint64_t fullWaits;   // Enqueues that found the input ring full
+    uint64_t fullWaitNs;
+    uint64_t emptyWaits;  // Dequeues that found the input ring empty (idle workers)
+    uint64_t emptyWaitNs;
+} pipeline_stage_stats;
+
+typedef struct pipeline_slot {
+    void *item;
+    uint64_t seq;        // Position in the ring's enqueue order, used by ordered stages
+    uint64_t enqueuedNs;
+} pipeline_slot;
+
+// Bounded blocking ring between two stages, buffer2's CircularBuffer with shutdown and counters
+typedef struct pipeline_ring {
+    pipeline_slot *slots;
+    size_t capacity;
+    size_t head;
+    size_t tail;
+    size_t count;
+    uint64_t nextSeq;
+    bool closed;
+    pthread_mutex_t mutex;
+    pthread_cond_t notEmpty;
+    pthread_cond_t notFull;
+    uint64_t queueNs;    // Counters below are updated under mutex
+    uint64_t depthSum;
+    uint64_t depthMax;
+    uint64_t fullWaits;
+    uint64_t fullWaitNs;
+    uint64_t emptyWaits;
+    uint64_t emptyWaitNs;
+} pipeline_ring;
+
+typedef struct pipeline_stage {
+    char name[32];
+    pipeline_fn fn;
+    void *ctx;
+    int workers;
+    size_t capacity;            // Slots of the input ring
+    pipeline_order order;
+    pipeline_ring *input;
+    pipeline_ring *output;
+    pthread_t *threads;
+    int running;                // Workers still alive; the last one closes the output ring
+    uint64_t nextEmit;          // PIPELINE_ORDERED: sequence number whose result goes out next
+    pthread_mutex_t mxStage;
+    pthread_cond_t turn;        // Signalled when nextEmit advances
+    uint64_t items;             // Updated atomically by the workers
+    uint64_t dropped;
+    uint64_t busyNs;
+    uint64_t maxBusyNs;
+    uint64_t orderWaitNs;
+} pipeline_stage;
+
+/**
+ * Chain of stages connected by bounded rings: ring i feeds stage i and the
+ * last ring holds the results for pipeline_next. A full ring blocks the stage
+ * (or pipeline_submit) in front of it, so a slow stage throttles everything
+ * upstream instead of letting queues grow.
+ */
+typedef struct pipeline {
+    pipeline_stage stages[PIPELINE_MAX_STAGES];
+    pipeline_ring *rings[PIPELINE_MAX_STAGES + 1];
+    int stageCount;
+    size_t outputCapacity;
+    bool started;
+} pipeline;
+
+/**
+ * Creates an empty pipeline whose result ring has `outputCapacity` slots
+ * (0 means PIPELINE_DEFAULT_CAPACITY). Returns NULL on allocation failure.
+ */
+pipeline* pipeline_init(size_t outputCapacity);
+
+/**
+ * Appends a stage run by `workers` threads reading from a ring of
+ * `capacity` slots (0 means PIPELINE_DEFAULT_CAPACITY). Must be called before
+ * pipeline_start. Returns the stage index, or -1 on invalid arguments or when
+ * PIPELINE_MAX_STAGES stages already exist.
+ */
+int pipeline_add_stage(pipeline *p, const char *name, pipeline_fn fn, void *ctx, int workers, size_t capacity,
+                       pipeline_order order);
+
+/**
+ * Creates the rings and starts the worker threads. Returns false on failure,
+ * with no threads left running.
+ */
+bool pipeline_start(pipeline *p);
+
+/**
+ * Feeds an item to the first stage, blocking while its ring is full.
+ * Returns false after pipeline_close; the item is not taken.
+ */
+bool pipeline_submit(pipeline *p, void *item);
+
+/**
+ * Ends the input. Stages finish the items already submitted and stop.
+ */
+void pipeline_close(pipeline *p);
+
+/**
+ * Returns the next result of the last stage, blocking until one is ready,
+ * or NULL once the pipeline is closed and drained. Results must be taken
+ * unless the last stage drops every item, otherwise the workers block on
+ * the full result ring.
+ */
+void* pipeline_next(pipeline *p);
+
+/**
+ * Closes the input if still open, waits for all workers and frees the
+ * pipeline. Results not taken with pipeline_next are discarded.
+ */
+void pipeline_deinit(pipeline *p);
+
+/**
+ * Copies the counters of stage `stage`. Returns false for an invalid index.
+ */
+bool pipeline_get_stats(pipeline *p, int stage, pipeline_stage_stats *stats);
+
+/**
+ * Prints a table of all stage counters to `out` and names the stage with the
+ * largest callback time per worker, the likely bottleneck.
+ */
+void pipeline_print_stats(pipeline *p, FILE *out);
+
+#endif // PIPELINE_H
@@ -5,6 +5,8 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
+#include "monte_carlo.h"
 
 #define MAXLINE 4096
 #define DEFAULT_THREADCOUNT 10
@@ -17,53 +19,72 @@ typedef struct argsEstimation
 {
     pthread_t tid;
     UINT seed;
-    int samplesCount;
+    long long samplesCount;
+    mc_rng rng;            // fast mode: xoshiro256** stream of this thread
+    uint64_t *insideCount; // slot of this thread in the preallocated results array
 } argsEstimation_t;
 
-void ReadArguments(int argc, char **argv, int *threadCount, int *samplesCount);
+void ReadArguments(int argc, char **argv, int *threadCount, long long *samplesCount, bool *fast);
 void *pi_estimation(void *args);
+void *pi_estimation_fast(void *args);
 
 int main(int argc, char **argv)
 {
-    int threadCount, samplesCount;
-    double *subresult;
-    ReadArguments(argc, argv, &threadCount, &samplesCount);
+    int threadCount;
+    long long samplesCount;
+    bool fast;
+    ReadArguments(argc, argv, &threadCount, &samplesCount, &fast);
     argsEstimation_t *estimations = (argsEstimation_t *)malloc(sizeof(argsEstimation_t) * threadCount);
     if (estimations == NULL)
         ERR("Malloc error for estimation arguments!");
+    // threads write their counts here, nothing is allocated per thread
+    uint64_t *insideCounts = (uint64_t *)malloc(sizeof(uint64_t) * threadCount);
+    if (insideCounts == NULL)
+        ERR("Malloc error for results!");
     srand(time(NULL));
+    uint64_t fastSeed = (uint64_t)time(NULL);
     for (int i = 0; i < threadCount; i++)
     {
         estimations[i].seed = rand();
         estimations[i].samplesCount = samplesCount;
+        estimations[i].insideCount = &insideCounts[i];
+        if (fast)
+            mc_rng_seed(&estimations[i].rng, fastSeed, i);
     }
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
     for (int i = 0; i < threadCount; i++)
     {
-        int err = pthread_create(&(estimations[i].tid), NULL, pi_estimation, &estimations[i]);
+        int err = pthread_create(&(estimations[i].tid), NULL, fast ? pi_estimation_fast : pi_estimation, &estimations[i]);
         if (err != 0)
             ERR("Couldn't create thread");
     }
-    double cumulativeResult = 0.0;
+    uint64_t cumulativeInside = 0;
     for (int i = 0; i < threadCount; i++)
     {
-        int err = pthread_join(estimations[i].tid, (void *)&subresult);
+        int err = pthread_join(estimations[i].tid, NULL);
         if (err != 0)
             ERR("Can't join with a thread");
-        if (NULL != subresult)
-        {
-            cumulativeResult += *subresult;
-            free(subresult);
-        }
+        cumulativeInside += insideCounts[i];
     }
-    double result = cumulativeResult / threadCount;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double result = 4.0 * (double)cumulativeInside / ((double)samplesCount * threadCount);
     printf("PI ~= %f\n", result);
+    if (fast)
+    {
+        double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+        printf("%lld samples in %.3f s, %.1f M samples/s (%s kernel)\n", samplesCount * threadCount, seconds,
+               samplesCount * threadCount / seconds / 1e6, mc_impl_name());
+    }
+    free(insideCounts);
     free(estimations);
 }
 
-void ReadArguments(int argc, char **argv, int *threadCount, int *samplesCount)
+void ReadArguments(int argc, char **argv, int *threadCount, long long *samplesCount, bool *fast)
 {
     *threadCount = DEFAULT_THREADCOUNT;
     *samplesCount = DEFAULT_SAMPLESIZE;
+    *fast = false;
 
     if (argc >= 2)
     {
@@ -76,30 +97,47 @@ void ReadArguments(int argc, char **argv, int *threadCount, int *samplesCount)
     }
     if (argc >= 3)
     {
-        *samplesCount = atoi(argv[2]);
+        *samplesCount = atoll(argv[2]);
         if (*samplesCount <= 0)
         {
             printf("Invalid value for 'samplesCount'");
             exit(EXIT_FAILURE);
         }
     }
+    // "fast": xoshiro256** and a vectorized test instead of rand_r and sqrt
+    if (argc >= 4)
+    {
+        if (strcmp(argv[3], "fast") == 0)
+            *fast = true;
+        else if (strcmp(argv[3], "rand") != 0)
+        {
+            printf("Invalid value for 'mode', expected rand or fast");
+            exit(EXIT_FAILURE);
+        }
+    }
 }
 
 void *pi_estimation(void *voidPtr)
 {
     argsEstimation_t *args = voidPtr;
-    double *result;
-    if (NULL == (result = malloc(sizeof(double))))
-        ERR("malloc");
 
-    int insideCount = 0;
-    for (int i = 0; i < args->samplesCount; i++)
+    uint64_t insideCount = 0;
+    for (long long i = 0; i < args->samplesCount; i++)
     {
         double x = ((double)rand_r(&args->seed) / (double)RAND_MAX);
         double y = ((double)rand_r(&args->seed) / (double)RAND_MAX);
         if (sqrt(x * x + y * y) <= 1.0)
             insideCount++;
     }
-    *result = 4.0 * (double)insideCount / (double)args->samplesCount;
-    return result;
+    *args->insideCount = insideCount;
+    return NULL;
+}
+
+void *pi_estimation_fast(void *voidPtr)
+{
+    argsEstimation_t *args = voidPtr;
+    // the generator state lives in a local copy, the shared array is written once
+    mc_rng rng = args->rng;
+    *args->insideCount = mc_count_inside(&rng, args->samplesCount);
+    return NULL;
 }
\ No newline at end of file
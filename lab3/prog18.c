@@ -4,38 +4,64 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include <unistd.h>
+#include "binomial.h"
+#include "monte_carlo.h"
 
 #define MAXLINE 4096
 #define DEFAULT_N 1000
 #define DEFAULT_K 10
 #define BIN_COUNT 11
+#define CACHE_LINE 64
+#define BATCH 4096
 #define NEXT_DOUBLE(seedptr) ((double)rand_r(seedptr) / (double)RAND_MAX)
 #define ERR(source) (perror(source), fprintf(stderr, "%s:%d\n", __FILE__, __LINE__), exit(EXIT_FAILURE))
 
 typedef unsigned int UINT;
+typedef enum throwMode
+{
+    MODE_LOCKED,     // balls claimed one by one from a shared pool, bins behind per-bin mutexes
+    MODE_PARTITIONED // fixed share of balls per thread, private bins merged after join
+} throwMode_t;
+typedef enum sampler
+{
+    SAMPLER_RAND,     // throwBall: one rand_r double per coin flip
+    SAMPLER_POPCOUNT, // popcount of BIN_COUNT - 1 bits of one xoshiro256** word
+    SAMPLER_BATCH     // binomial_fill: BATCH balls per call, four per word (partitioned mode only)
+} sampler_t;
+
 typedef struct argsThrower
 {
     pthread_t tid;
     UINT seed;
+    sampler_t sampler;
+    mc_rng rng;
     int *pBallsThrown;
     int *pBallsWaiting;
     int *bins;
     pthread_mutex_t *mxBins;
     pthread_mutex_t *pmxBallsThrown;
     pthread_mutex_t *pmxBallsWaiting;
-} argsThrower_t;
+    int ballsToThrow;             // MODE_PARTITIONED: share of this thread
+    long long localBins[BIN_COUNT]; // MODE_PARTITIONED: written only by this thread
+} __attribute__((aligned(CACHE_LINE))) argsThrower_t;
 
-void ReadArguments(int argc, char **argv, int *ballsCount, int *throwersCount);
-void make_throwers(argsThrower_t *argsArray, int throwersCount);
+void ReadArguments(int argc, char **argv, int *ballsCount, int *throwersCount, throwMode_t *mode, sampler_t *sampler);
+void make_throwers(argsThrower_t *argsArray, int throwersCount, throwMode_t mode);
+void join_throwers(argsThrower_t *argsArray, int throwersCount);
 void *throwing_func(void *args);
+void *partitioned_throwing_func(void *args);
 int throwBall(UINT *seedptr);
+int sampleBall(argsThrower_t *args);
 
 int main(int argc, char **argv)
 {
     int ballsCount, throwersCount;
-    ReadArguments(argc, argv, &ballsCount, &throwersCount);
-    int ballsThrown = 0, bt = 0;
+    throwMode_t mode;
+    sampler_t sampler;
+    ReadArguments(argc, argv, &ballsCount, &throwersCount, &mode, &sampler);
+    int ballsThrown = 0;
     int ballsWaiting = ballsCount;
     pthread_mutex_t mxBallsThrown = PTHREAD_MUTEX_INITIALIZER;
     pthread_mutex_t mxBallsWaiting = PTHREAD_MUTEX_INITIALIZER;
@@ -47,51 +73,73 @@ int main(int argc, char **argv)
         if (pthread_mutex_init(&mxBins[i], NULL))
             ERR("Couldn't initialize mutex!");
     }
-    argsThrower_t *args = (argsThrower_t *)malloc(sizeof(argsThrower_t) * throwersCount);
-    if (args == NULL)
+    // aligned so that the private bins of neighbouring threads never share a cache line
+    argsThrower_t *args;
+    if (posix_memalign((void **)&args, CACHE_LINE, sizeof(argsThrower_t) * throwersCount))
         ERR("Malloc error for throwers arguments!");
     srand(time(NULL));
+    uint64_t rngSeed = ((uint64_t)rand() << 32) ^ (uint64_t)rand();
     for (int i = 0; i < throwersCount; i++)
     {
         args[i].seed = (UINT)rand();
+        args[i].sampler = sampler;
+        if (sampler != SAMPLER_RAND)
+            mc_rng_seed(&args[i].rng, rngSeed, i);
         args[i].pBallsThrown = &ballsThrown;
         args[i].pBallsWaiting = &ballsWaiting;
         args[i].bins = bins;
         args[i].pmxBallsThrown = &mxBallsThrown;
         args[i].pmxBallsWaiting = &mxBallsWaiting;
         args[i].mxBins = mxBins;
+        // the remainder goes to the first threads, one ball each
+        args[i].ballsToThrow = ballsCount / throwersCount + (i < ballsCount % throwersCount ? 1 : 0);
+        memset(args[i].localBins, 0, sizeof(args[i].localBins));
     }
-    make_throwers(args, throwersCount);
-    while (bt < ballsCount)
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    make_throwers(args, throwersCount, mode);
+    join_throwers(args, throwersCount);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    long long totals[BIN_COUNT];
+    uint64_t observed[BIN_COUNT];
+    for (int i = 0; i < BIN_COUNT; i++)
     {
-        sleep(1);
-        pthread_mutex_lock(&mxBallsThrown);
-        bt = ballsThrown;
-        pthread_mutex_unlock(&mxBallsThrown);
+        totals[i] = bins[i];
+        for (int t = 0; t < throwersCount; t++)
+            totals[i] += args[t].localBins[i];
+        observed[i] = totals[i];
     }
-    int realBallsCount = 0;
+    long long realBallsCount = 0;
     double meanValue = 0.0;
     for (int i = 0; i < BIN_COUNT; i++)
     {
-        realBallsCount += bins[i];
-        meanValue += bins[i] * i;
+        realBallsCount += totals[i];
+        meanValue += totals[i] * i;
     }
     meanValue = meanValue / realBallsCount;
     printf("Bins count:\n");
     for (int i = 0; i < BIN_COUNT; i++)
-        printf("%d\t", bins[i]);
-    printf("\nTotal balls count : %d\nMean value: %f\n", realBallsCount, meanValue);
-    // for (int i = 0; i < BIN_COUNT; i++) pthread_mutex_destroy(&mxBins[i]);
-    // free(args);
-    // The resources used by detached threads cannod be freed as we are not sure
-    // if they are running yet.
+        printf("%lld\t", totals[i]);
+    printf("\nTotal balls count : %lld\nMean value: %f\n", realBallsCount, meanValue);
+    double chiSquare = binomial_chi_square(observed, BIN_COUNT - 1);
+    printf("Chi-square vs Binomial(%d, 1/2): %.2f, p = %.4f\n", BIN_COUNT - 1, chiSquare,
+           chi_square_p_value(chiSquare, BIN_COUNT - 1));
+    double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    printf("Time: %.3f s, %.0f balls/s\n", seconds, realBallsCount / seconds);
+
+    for (int i = 0; i < BIN_COUNT; i++)
+        pthread_mutex_destroy(&mxBins[i]);
+    free(args);
     exit(EXIT_SUCCESS);
 }
 
-void ReadArguments(int argc, char **argv, int *ballsCount, int *throwersCount)
+void ReadArguments(int argc, char **argv, int *ballsCount, int *throwersCount, throwMode_t *mode, sampler_t *sampler)
 {
     *ballsCount = DEFAULT_N;
     *throwersCount = DEFAULT_K;
+    *mode = MODE_LOCKED;
+    *sampler = SAMPLER_RAND;
     if (argc >= 2)
     {
         *ballsCount = atoi(argv[1]);
@@ -110,21 +158,53 @@ void ReadArguments(int argc, char **argv, int *ballsCount, int *throwersCount)
             exit(EXIT_FAILURE);
         }
     }
+    if (argc >= 4)
+    {
+        if (strcmp(argv[3], "partitioned") == 0)
+            *mode = MODE_PARTITIONED;
+        else if (strcmp(argv[3], "locked") != 0)
+        {
+            printf("Invalid value for 'mode', expected locked or partitioned");
+            exit(EXIT_FAILURE);
+        }
+    }
+    if (argc >= 5)
+    {
+        if (strcmp(argv[4], "popcount") == 0)
+            *sampler = SAMPLER_POPCOUNT;
+        else if (strcmp(argv[4], "batch") == 0)
+            *sampler = SAMPLER_BATCH;
+        else if (strcmp(argv[4], "rand") != 0)
+        {
+            printf("Invalid value for 'sampler', expected rand, popcount or batch");
+            exit(EXIT_FAILURE);
+        }
+    }
+    if (*sampler == SAMPLER_BATCH && *mode != MODE_PARTITIONED)
+    {
+        printf("The batch sampler needs the partitioned mode");
+        exit(EXIT_FAILURE);
+    }
 }
 
-void make_throwers(argsThrower_t *argsArray, int throwersCount)
+void make_throwers(argsThrower_t *argsArray, int throwersCount, throwMode_t mode)
 {
-    pthread_attr_t threadAttr;
-    if (pthread_attr_init(&threadAttr))
-        ERR("Couldn't create pthread_attr_t");
-    if (pthread_attr_setdetachstate(&threadAttr, PTHREAD_CREATE_DETACHED))
-        ERR("Couldn't setdetachsatate on pthread_attr_t");
     for (int i = 0; i < throwersCount; i++)
     {
-        if (pthread_create(&argsArray[i].tid, &threadAttr, throwing_func, &argsArray[i]))
+        if (pthread_create(&argsArray[i].tid, NULL, mode == MODE_PARTITIONED ? partitioned_throwing_func : throwing_func,
+                           &argsArray[i]))
             ERR("Couldn't create thread");
     }
-    pthread_attr_destroy(&threadAttr);
+}
+
+// Joinable threads: main waits for the last ball instead of polling ballsThrown every second
+void join_throwers(argsThrower_t *argsArray, int throwersCount)
+{
+    for (int i = 0; i < throwersCount; i++)
+    {
+        if (pthread_join(argsArray[i].tid, NULL))
+            ERR("Couldn't join thread");
+    }
 }
 
 void *throwing_func(void *voidArgs)
@@ -143,7 +223,7 @@ void *throwing_func(void *voidArgs)
             pthread_mutex_unlock(args->pmxBallsWaiting);
             break;
         }
-        int binno = throwBall(&args->seed);
+        int binno = sampleBall(args);
         pthread_mutex_lock(&args->mxBins[binno]);
         args->bins[binno] += 1;
         pthread_mutex_unlock(&args->mxBins[binno]);
@@ -154,6 +234,38 @@ void *throwing_func(void *voidArgs)
     return NULL;
 }
 
+void *partitioned_throwing_func(void *voidArgs)
+{
+    argsThrower_t *args = voidArgs;
+    // no shared state until join - bins in registers/stack, copied out once
+    long long bins[BIN_COUNT] = {0};
+    if (args->sampler == SAMPLER_BATCH)
+    {
+        uint8_t batch[BATCH];
+        for (int left = args->ballsToThrow; left > 0; left -= BATCH)
+        {
+            int n = left < BATCH ? left : BATCH;
+            binomial_fill(&args->rng, BIN_COUNT - 1, batch, n);
+            for (int i = 0; i < n; i++)
+                bins[batch[i]]++;
+        }
+    }
+    else
+    {
+        for (int i = 0; i < args->ballsToThrow; i++)
+            bins[sampleBall(args)]++;
+    }
+    memcpy(args->localBins, bins, sizeof(bins));
+    return NULL;
+}
+
+int sampleBall(argsThrower_t *args)
+{
+    if (args->sampler == SAMPLER_POPCOUNT)
+        return binomial_sample(&args->rng, BIN_COUNT - 1);
+    return throwBall(&args->seed);
+}
+
 /* returns # of bin where ball has landed */
 int throwBall(UINT *seedptr)
 {
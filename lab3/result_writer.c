@@ -0,0 +1,235 @@
+#define _GNU_SOURCE
+#include "result_writer.h"
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define ERR(source) (perror(source), fprintf(stderr, "%s:%d\n", __FILE__, __LINE__), exit(EXIT_FAILURE))
+
+// rekord w arenie: numer pracownika, długość ścieżki, ścieżka bez '\0'
+typedef struct record_header {
+    uint32_t workerId;
+    uint32_t length;
+} record_header;
+
+#define MAX_LINE (sizeof("Pracownik nr 4294967295 zakończył zliczanie liter w pliku \n"))
+#define MAX_TABLE (sizeof("Wyniki:\n\n\n\n") + LETTER_COUNT * sizeof("x=18446744073709551615 "))
+
+// Zapis wszystkich fragmentów jednym writev, z obsługą częściowych zapisów
+static void flush_output(result_writer *writer)
+{
+    struct iovec *iov = writer->iov;
+    int count = writer->iovCount;
+    while(count > 0)
+    {
+        ssize_t written = writev(writer->fd, iov, count);
+        if(written == -1)
+        {
+            if(errno == EINTR)
+                continue;
+            ERR("writev");
+        }
+        writer->bytes += written;
+        writer->writes++;
+        while(count > 0 && (size_t)written >= iov->iov_len)
+        {
+            written -= iov->iov_len;
+            iov++;
+            count--;
+        }
+        if(count > 0)
+        {
+            iov->iov_base = (char *)iov->iov_base + written;
+            iov->iov_len -= written;
+        }
+    }
+    writer->iovCount = 0;
+    writer->iov[0].iov_base = writer->out;
+    writer->iov[0].iov_len = 0;
+}
+
+// Zwraca miejsce na co najmniej `need` bajtów w bieżącym fragmencie
+static char* reserve(result_writer *writer, size_t need)
+{
+    struct iovec *cur = &writer->iov[writer->iovCount];
+    if(cur->iov_len + need <= RW_CHUNK_SIZE)
+        return (char *)cur->iov_base + cur->iov_len;
+
+    // bieżący fragment pełny - następny albo zapis wszystkich
+    writer->iovCount++;
+    if(writer->iovCount == RW_CHUNKS)
+        flush_output(writer);
+    cur = &writer->iov[writer->iovCount];
+    cur->iov_base = writer->out + (size_t)writer->iovCount * RW_CHUNK_SIZE;
+    cur->iov_len = 0;
+    return cur->iov_base;
+}
+
+static char* append_str(char *p, const char *s, size_t len)
+{
+    memcpy(p, s, len);
+    return p + len;
+}
+
+static char* append_u64(char *p, uint64_t v)
+{
+    char digits[20];
+    int n = 0;
+    do
+    {
+        digits[n++] = '0' + v % 10;
+        v /= 10;
+    } while(v > 0);
+    while(n > 0)
+        *p++ = digits[--n];
+    return p;
+}
+
+#define APPEND_LITERAL(p, s) append_str(p, s, sizeof(s) - 1)
+
+static void format_record(result_writer *writer, const record_header *header, const char *path)
+{
+    char *start = reserve(writer, MAX_LINE + header->length);
+    char *p = APPEND_LITERAL(start, "Pracownik nr ");
+    p = append_u64(p, header->workerId);
+    p = APPEND_LITERAL(p, " zakończył zliczanie liter w pliku ");
+    p = append_str(p, path, header->length);
+    *p++ = '\n';
+    writer->iov[writer->iovCount].iov_len += p - start;
+}
+
+static void format_table(result_writer *writer)
+{
+    letter_snapshot snapshot;
+    letter_stats_snapshot(writer->letters, &snapshot);
+
+    char *start = reserve(writer, MAX_TABLE);
+    char *p = APPEND_LITERAL(start, "Wyniki:\n");
+    for(int i = 0; i < LETTER_COUNT; i++)
+    {
+        if(i == 26)
+            *p++ = '\n';
+        if(snapshot.counts[i] == 0)
+            continue;
+        *p++ = i < 26 ? 'A' + i : 'a' + (i - 26);
+        *p++ = '=';
+        p = append_u64(p, snapshot.counts[i]);
+        *p++ = ' ';
+    }
+    p = APPEND_LITERAL(p, "\n\n");
+    writer->iov[writer->iovCount].iov_len += p - start;
+}
+
+static void* writer_thread(void *voidArgs)
+{
+    result_writer *writer = voidArgs;
+    for(;;)
+    {
+        pthread_mutex_lock(&writer->mxPending);
+        while(writer->pendingLen == 0 && !writer->stopped)
+            pthread_cond_wait(&writer->cvData, &writer->mxPending);
+        if(writer->pendingLen == 0)
+        {
+            pthread_mutex_unlock(&writer->mxPending);
+            break; // zatrzymany i wszystko zapisane
+        }
+        // zamiana aren - pracownicy dopisują do pustej, gdy my formatujemy pełną
+        char *batch = writer->pending;
+        size_t len = writer->pendingLen;
+        writer->pending = writer->spare;
+        writer->spare = batch;
+        writer->pendingLen = 0;
+        pthread_cond_broadcast(&writer->cvSpace);
+        pthread_mutex_unlock(&writer->mxPending);
+
+        for(size_t off = 0; off < len;)
+        {
+            record_header header;
+            memcpy(&header, batch + off, sizeof(header));
+            format_record(writer, &header, batch + off + sizeof(header));
+            off += sizeof(header) + header.length;
+            writer->records++;
+        }
+        if(writer->verbosity == RW_TABLES)
+            format_table(writer);
+        // zapis po każdej serii - wyjście nie czeka na zapełnienie bufora
+        writer->iovCount++;
+        flush_output(writer);
+    }
+    return NULL;
+}
+
+result_writer* result_writer_init(int fd, result_verbosity verbosity, letter_stats *letters)
+{
+    result_writer *writer = calloc(1, sizeof(result_writer));
+    if(writer == NULL)
+        return NULL;
+    writer->fd = fd;
+    writer->verbosity = verbosity;
+    writer->letters = letters;
+    writer->pending = malloc(RW_ARENA_SIZE);
+    writer->spare = malloc(RW_ARENA_SIZE);
+    writer->out = malloc((size_t)RW_CHUNKS * RW_CHUNK_SIZE);
+    if(writer->pending == NULL || writer->spare == NULL || writer->out == NULL)
+    {
+        free(writer->pending);
+        free(writer->spare);
+        free(writer->out);
+        free(writer);
+        return NULL;
+    }
+    writer->iov[0].iov_base = writer->out;
+    writer->iov[0].iov_len = 0;
+
+    if(pthread_mutex_init(&writer->mxPending, NULL) != 0)
+        ERR("pthread_mutex_init");
+    if(pthread_cond_init(&writer->cvData, NULL) != 0 || pthread_cond_init(&writer->cvSpace, NULL) != 0)
+        ERR("pthread_cond_init");
+    if(verbosity != RW_QUIET && pthread_create(&writer->tid, NULL, writer_thread, writer) != 0)
+        ERR("Cannot create writer thread");
+    return writer;
+}
+
+void result_writer_push(result_writer *writer, int workerId, const char *path)
+{
+    if(writer->verbosity == RW_QUIET)
+        return;
+
+    record_header header = { .workerId = (uint32_t)workerId, .length = (uint32_t)strlen(path) };
+    size_t need = sizeof(header) + header.length;
+
+    pthread_mutex_lock(&writer->mxPending);
+    while(writer->pendingLen + need > RW_ARENA_SIZE)
+        pthread_cond_wait(&writer->cvSpace, &writer->mxPending);
+    bool wasEmpty = writer->pendingLen == 0;
+    memcpy(writer->pending + writer->pendingLen, &header, sizeof(header));
+    memcpy(writer->pending + writer->pendingLen + sizeof(header), path, header.length);
+    writer->pendingLen += need;
+    // wątek zapisu czeka tylko na pustą arenę
+    if(wasEmpty)
+        pthread_cond_signal(&writer->cvData);
+    pthread_mutex_unlock(&writer->mxPending);
+}
+
+void result_writer_deinit(result_writer *writer)
+{
+    if(writer->verbosity != RW_QUIET)
+    {
+        pthread_mutex_lock(&writer->mxPending);
+        writer->stopped = true;
+        pthread_cond_signal(&writer->cvData);
+        pthread_mutex_unlock(&writer->mxPending);
+        if(pthread_join(writer->tid, NULL) != 0)
+            ERR("pthread join");
+    }
+
+    pthread_cond_destroy(&writer->cvSpace);
+    pthread_cond_destroy(&writer->cvData);
+    pthread_mutex_destroy(&writer->mxPending);
+    free(writer->pending);
+    free(writer->spare);
+    free(writer->out);
+    free(writer);
+}
@@ -0,0 +1,61 @@
+#ifndef RESULT_WRITER_H
+#define RESULT_WRITER_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/uio.h>
+#include "letter_stats.h"
+
+#define RW_ARENA_SIZE (256 * 1024) // Records waiting for the writer thread
+#define RW_CHUNK_SIZE (64 * 1024)  // One iovec of formatted output
+#define RW_CHUNKS 16               // Up to RW_CHUNKS * RW_CHUNK_SIZE bytes per writev
+
+typedef enum result_verbosity {
+    RW_QUIET,   // No per-file output
+    RW_FILES,   // One line per finished file
+    RW_TABLES   // Lines plus the letter totals after every batch of lines
+} result_verbosity;
+
+typedef struct result_writer {
+    int fd;
+    result_verbosity verbosity;
+    letter_stats *letters;   // Source of the totals printed in RW_TABLES
+    pthread_t tid;
+
+    pthread_mutex_t mxPending;
+    pthread_cond_t cvData;   // Records arrived or the writer is stopping
+    pthread_cond_t cvSpace;  // The writer took the pending arena
+    char *pending;           // Records appended by the workers
+    size_t pendingLen;
+    char *spare;             // Arena being formatted by the writer thread
+    bool stopped;
+
+    char *out;               // RW_CHUNKS chunks of formatted text
+    struct iovec iov[RW_CHUNKS];
+    int iovCount;
+
+    uint64_t records;        // Statistics, owned by the writer thread
+    uint64_t bytes;
+    uint64_t writes;
+} result_writer;
+
+/**
+ * Starts a writer thread that formats the records pushed by workers and
+ * writes them to fd with writev. Returns NULL on failure.
+ */
+result_writer* result_writer_init(int fd, result_verbosity verbosity, letter_stats *letters);
+
+/**
+ * Queues "worker finished path". Copies the path; blocks only while the
+ * pending arena is full. Does nothing in RW_QUIET.
+ */
+void result_writer_push(result_writer *writer, int workerId, const char *path);
+
+/**
+ * Writes everything still queued, stops the thread and frees the writer.
+ */
+void result_writer_deinit(result_writer *writer);
+
+#endif // RESULT_WRITER_H
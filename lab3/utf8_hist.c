@@ -0,0 +1,327 @@
+#include "utf8_hist.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Dekoder UTF-8 jako automat skończony: bajt -> klasa, (stan, klasa) -> stan.
+// Stany są wielokrotnościami liczby klas, więc przejście to jedno dodawanie i odczyt z tablicy.
+#define CLASSES 12
+#define ACCEPT 0
+#define REJECT CLASSES
+
+static const uint8_t byteClass[256] = {
+    [0x00 ... 0x7f] = 0,  // ASCII
+    [0x80 ... 0x8f] = 1,  // bajty kontynuacji, podzielone według zakresów wymaganych po E0, ED, F0 i F4
+    [0x90 ... 0x9f] = 9,
+    [0xa0 ... 0xbf] = 7,
+    [0xc0 ... 0xc1] = 8,  // nadmiarowe kodowanie ASCII
+    [0xc2 ... 0xdf] = 2,  // początek sekwencji 2-bajtowej
+    [0xe0] = 10,
+    [0xe1 ... 0xec] = 3,  // początek sekwencji 3-bajtowej
+    [0xed] = 4,           // bez surogatów U+D800-U+DFFF
+    [0xee ... 0xef] = 3,
+    [0xf0] = 11,
+    [0xf1 ... 0xf3] = 6,  // początek sekwencji 4-bajtowej
+    [0xf4] = 5,           // nie dalej niż U+10FFFF
+    [0xf5 ... 0xff] = 8,
+};
+
+static const uint8_t transition[9 * CLASSES] = {
+    // klasa:  0   1   2   3   4   5   6   7   8   9  10  11
+    /*  0 */   0, 12, 24, 36, 60, 96, 84, 12, 12, 12, 48, 72, // poza sekwencją
+    /* 12 */  12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, // błąd
+    /* 24 */  12,  0, 12, 12, 12, 12, 12,  0, 12,  0, 12, 12, // brakuje 1 bajtu
+    /* 36 */  12, 24, 12, 12, 12, 12, 12, 24, 12, 24, 12, 12, // brakuje 2 bajtów
+    /* 48 */  12, 12, 12, 12, 12, 12, 12, 24, 12, 12, 12, 12, // po E0: A0-BF
+    /* 60 */  12, 24, 12, 12, 12, 12, 12, 12, 12, 24, 12, 12, // po ED: 80-9F
+    /* 72 */  12, 12, 12, 12, 12, 12, 12, 36, 12, 36, 12, 12, // po F0: 90-BF
+    /* 84 */  12, 36, 12, 12, 12, 12, 12, 36, 12, 36, 12, 12, // po F1-F3: 80-BF
+    /* 96 */  12, 36, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, // po F4: 80-8F
+};
+
+#define ASCII_MASK 0x8080808080808080ull
+#define PAYLOAD_BITS 0x1e1e1e1e1e1e1e1eull // bity 1-4 bajtu wiodącego; zerowe tylko w C0 i C1
+#define BYTE_MAX_NO_CARRY 0x7f7f7f7f7f7f7f7full
+#define FIRST_BYTE 0x80ull
+
+// Kosze podhistogramu: litery, inne znaki i kosz bajtów kontynuacji (pomijany przy sumowaniu)
+#define BINS(alphabet) ((alphabet)->count + 2)
+
+static int compare_code_points(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+static size_t letter_index(const utf8_alphabet *alphabet, uint32_t codePoint)
+{
+    if (codePoint < UTF8_DIRECT)
+        return alphabet->direct[codePoint];
+    size_t lo = 0, hi = alphabet->highCount;
+    while (lo < hi)
+    {
+        size_t mid = lo + (hi - lo) / 2;
+        if (alphabet->high[mid] == codePoint)
+            return alphabet->highIndex[mid];
+        if (alphabet->high[mid] < codePoint)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return alphabet->count;
+}
+
+// Bajt k słowa zawsze na bitach 8k..8k+7, niezależnie od kolejności bajtów procesora
+static inline uint64_t le64(uint64_t word)
+{
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    return __builtin_bswap64(word);
+#else
+    return word;
+#endif
+}
+
+// Jeden krok automatu; zwraca true po skompletowaniu znaku
+static inline bool decode_step(uint32_t *state, uint32_t *codePoint, unsigned char byte)
+{
+    unsigned type = byteClass[byte];
+    *codePoint = *state != ACCEPT ? (byte & 0x3fu) | (*codePoint << 6) : (0xffu >> type) & byte;
+    *state = transition[*state + type];
+    return *state == ACCEPT;
+}
+
+utf8_alphabet* utf8_alphabet_init(const char *letters)
+{
+    size_t len = strlen(letters);
+    utf8_alphabet *alphabet = calloc(1, sizeof(utf8_alphabet));
+    if (alphabet == NULL)
+        return NULL;
+    // liter nie może być więcej niż bajtów napisu
+    alphabet->letters = malloc((len + 1) * sizeof(uint32_t));
+    alphabet->high = malloc((len + 1) * sizeof(uint32_t));
+    alphabet->highIndex = malloc((len + 1) * sizeof(uint16_t));
+    if (alphabet->letters == NULL || alphabet->high == NULL || alphabet->highIndex == NULL)
+        goto fail;
+
+    uint32_t state = ACCEPT, codePoint = 0;
+    for (size_t i = 0; i < len; i++)
+    {
+        if (decode_step(&state, &codePoint, (unsigned char)letters[i]))
+        {
+            if (alphabet->count == UTF8_MAX_LETTERS)
+                goto fail;
+            alphabet->letters[alphabet->count++] = codePoint;
+        }
+        else if (state == REJECT)
+            goto fail;
+    }
+    if (state != ACCEPT)
+        goto fail;
+
+    for (size_t i = 0; i < UTF8_DIRECT; i++)
+        alphabet->direct[i] = alphabet->count;
+    for (size_t i = 0; i < alphabet->count; i++)
+    {
+        if (alphabet->letters[i] < UTF8_DIRECT)
+        {
+            if (alphabet->direct[alphabet->letters[i]] != alphabet->count)
+                goto fail;
+            alphabet->direct[alphabet->letters[i]] = i;
+        }
+        else
+            alphabet->high[alphabet->highCount++] = alphabet->letters[i];
+    }
+    for (size_t i = 0; i < 256; i++)
+        alphabet->ascii[i] = i < 0x80 ? alphabet->direct[i] : alphabet->count + 1;
+    qsort(alphabet->high, alphabet->highCount, sizeof(uint32_t), compare_code_points);
+    for (size_t i = 0; i < alphabet->highCount; i++)
+    {
+        if (i > 0 && alphabet->high[i] == alphabet->high[i - 1])
+            goto fail;
+    }
+    for (size_t i = 0; i < alphabet->count; i++)
+    {
+        if (alphabet->letters[i] < UTF8_DIRECT)
+            continue;
+        uint32_t *found = bsearch(&alphabet->letters[i], alphabet->high, alphabet->highCount,
+                                  sizeof(uint32_t), compare_code_points);
+        alphabet->highIndex[found - alphabet->high] = i;
+    }
+    return alphabet;
+
+fail:
+    utf8_alphabet_deinit(alphabet);
+    return NULL;
+}
+
+void utf8_alphabet_deinit(utf8_alphabet *alphabet)
+{
+    if (alphabet == NULL)
+        return;
+    free(alphabet->letters);
+    free(alphabet->high);
+    free(alphabet->highIndex);
+    free(alphabet);
+}
+
+size_t utf8_encode(uint32_t codePoint, char out[4])
+{
+    if (codePoint < 0x80)
+    {
+        out[0] = codePoint;
+        return 1;
+    }
+    if (codePoint < 0x800)
+    {
+        out[0] = 0xc0 | codePoint >> 6;
+        out[1] = 0x80 | (codePoint & 0x3f);
+        return 2;
+    }
+    if (codePoint < 0x10000)
+    {
+        out[0] = 0xe0 | codePoint >> 12;
+        out[1] = 0x80 | (codePoint >> 6 & 0x3f);
+        out[2] = 0x80 | (codePoint & 0x3f);
+        return 3;
+    }
+    out[0] = 0xf0 | codePoint >> 18;
+    out[1] = 0x80 | (codePoint >> 12 & 0x3f);
+    out[2] = 0x80 | (codePoint >> 6 & 0x3f);
+    out[3] = 0x80 | (codePoint & 0x3f);
+    return 4;
+}
+
+bool utf8_hist_init(utf8_hist *hist, const utf8_alphabet *alphabet)
+{
+    hist->alphabet = alphabet;
+    hist->state = ACCEPT;
+    hist->codePoint = 0;
+    hist->invalid = 0;
+    hist->sub = calloc(UTF8_SUB_HISTS * BINS(alphabet), sizeof(uint64_t));
+    return hist->sub != NULL;
+}
+
+void utf8_hist_deinit(utf8_hist *hist)
+{
+    free(hist->sub);
+    hist->sub = NULL;
+}
+
+void utf8_hist_count(utf8_hist *hist, const unsigned char *data, size_t len)
+{
+    const utf8_alphabet *alphabet = hist->alphabet;
+    const uint16_t *direct = alphabet->direct, *ascii = alphabet->ascii;
+    size_t bins = BINS(alphabet);
+    uint64_t *sub0 = hist->sub, *sub1 = sub0 + bins, *sub2 = sub1 + bins, *sub3 = sub2 + bins;
+    uint32_t state = hist->state, codePoint = hist->codePoint;
+
+    size_t i = 0;
+    while (i < len)
+    {
+        // szybka ścieżka: słowa 8 bajtów bez automatu; wystarczy jeszcze jeden bajt za słowem
+        if (state == ACCEPT)
+        {
+            while (i + 9 <= len)
+            {
+                // Słowo przechodzi, jeśli zawiera tylko ASCII i całe sekwencje 2-bajtowe (m.in. wszystkie
+                // polskie litery): każdy bajt wiodący C2-DF ma za sobą bajt kontynuacji i każdy bajt
+                // kontynuacji ma przed sobą bajt wiodący. Maski mają ustawiony najstarszy bit bajtów danego rodzaju.
+                uint64_t word, next;
+                memcpy(&word, data + i, sizeof(word));
+                memcpy(&next, data + i + 1, sizeof(next));
+                word = le64(word);
+                next = le64(next);
+                uint64_t lead = word & word << 1 & ASCII_MASK;        // 11xxxxxx
+                uint64_t cont = word & ~(word << 1) & ASCII_MASK;     // 10xxxxxx
+                uint64_t nextCont = next & ~(next << 1) & ASCII_MASK; // 10xxxxxx, przesunięte o bajt
+                uint64_t wide = lead & word << 2;                      // 111xxxxx - sekwencja 3- lub 4-bajtowa
+                uint64_t overlong = lead & ~((word & PAYLOAD_BITS) + BYTE_MAX_NO_CARRY);
+                if ((wide | overlong | (nextCont ^ lead) | (cont & FIRST_BYTE)) != 0)
+                    break;
+
+                // bajty ASCII do swoich koszy, pozostałe do kosza pomijanego przy sumowaniu
+                sub0[ascii[data[i]]]++;
+                sub1[ascii[data[i + 1]]]++;
+                sub2[ascii[data[i + 2]]]++;
+                sub3[ascii[data[i + 3]]]++;
+                sub0[ascii[data[i + 4]]]++;
+                sub1[ascii[data[i + 5]]]++;
+                sub2[ascii[data[i + 6]]]++;
+                sub3[ascii[data[i + 7]]]++;
+                // znaki 2-bajtowe po kolei z maski bajtów wiodących
+                for (uint64_t m = lead; m != 0; m &= m - 1)
+                {
+                    const unsigned char *p = data + i + (__builtin_ctzll(m) >> 3);
+                    sub0[direct[(p[0] & 0x1fu) << 6 | (p[1] & 0x3fu)]]++;
+                }
+                // znak zaczęty ostatnim bajtem słowa jest już policzony razem ze swoją kontynuacją
+                i += 8 + (lead >> 63);
+            }
+            // słowo z innymi sekwencjami albo końcówka danych - najpierw bajty ASCII przed nimi
+            while (i < len && data[i] < 0x80)
+                sub0[direct[data[i++]]]++;
+            if (i == len)
+                break;
+
+            // znaki 2-bajtowe (m.in. wszystkie polskie litery) też bez automatu
+            unsigned char lead = data[i];
+            if (lead >= 0xc2 && lead <= 0xdf && i + 1 < len && (data[i + 1] & 0xc0) == 0x80)
+            {
+                sub1[direct[(lead & 0x1fu) << 6 | (data[i + 1] & 0x3fu)]]++;
+                i += 2;
+                continue;
+            }
+        }
+
+        uint32_t previous = state;
+        if (decode_step(&state, &codePoint, data[i]))
+            sub0[letter_index(alphabet, codePoint)]++;
+        else if (state == REJECT)
+        {
+            hist->invalid++;
+            state = ACCEPT;
+            // bajt, który przerwał sekwencję, może zaczynać następną
+            if (previous != ACCEPT)
+                continue;
+        }
+        i++;
+    }
+
+    hist->state = state;
+    hist->codePoint = codePoint;
+}
+
+void utf8_hist_finish(utf8_hist *hist)
+{
+    if (hist->state != ACCEPT)
+        hist->invalid++;
+    hist->state = ACCEPT;
+    hist->codePoint = 0;
+}
+
+uint64_t utf8_hist_get(const utf8_hist *hist, size_t index)
+{
+    size_t bins = BINS(hist->alphabet);
+    uint64_t total = 0;
+    for (int s = 0; s < UTF8_SUB_HISTS; s++)
+        total += hist->sub[s * bins + index];
+    return total;
+}
+
+void utf8_hist_add(utf8_hist *dst, const utf8_hist *src)
+{
+    size_t n = UTF8_SUB_HISTS * BINS(src->alphabet);
+    for (size_t i = 0; i < n; i++)
+        dst->sub[i] += src->sub[i];
+    dst->invalid += src->invalid;
+}
+
+void utf8_hist_ascii(const utf8_hist *hist, uint64_t counts[LETTER_COUNT])
+{
+    const utf8_alphabet *alphabet = hist->alphabet;
+    for (int i = 0; i < LETTER_COUNT; i++)
+    {
+        unsigned char c = i < 26 ? 'A' + i : 'a' + (i - 26);
+        size_t index = alphabet->direct[c];
+        counts[i] = index < alphabet->count ? utf8_hist_get(hist, index) : 0;
+    }
+}
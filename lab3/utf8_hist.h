@@ -0,0 +1,88 @@
+#ifndef UTF8_HIST_H
+#define UTF8_HIST_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "letter_hist.h"
+
+// Polish alphabet with the letters that appear only in borrowed words (Q, V, X)
+#define UTF8_ALPHABET_POLISH "AĄBCĆDEĘFGHIJKLŁMNŃOÓPQRSŚTUVWXYZŹŻaąbcćdeęfghijklłmnńoópqrsśtuvwxyzźż"
+#define UTF8_ALPHABET_ASCII "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz"
+
+#define UTF8_SUB_HISTS 4     // interleaved sub-histograms, as in letter_hist
+#define UTF8_DIRECT 0x800    // code points below this are classified with a single table lookup
+#define UTF8_MAX_LETTERS 4096
+
+typedef struct utf8_alphabet {
+    size_t count;                 // Number of letters; index `count` collects everything else
+    uint32_t *letters;            // Code points in the order they were given
+    uint16_t direct[UTF8_DIRECT]; // Code point -> letter index, `count` for other characters
+    uint16_t ascii[256];          // Byte -> bin in the fast path; bytes >= 0x80 go to the unused bin `count + 1`
+    uint32_t *high;               // Sorted code points >= UTF8_DIRECT with their indices in highIndex
+    uint16_t *highIndex;
+    size_t highCount;
+} utf8_alphabet;
+
+/**
+ * Streaming decoder state and histogram of one alphabet. The decoder keeps a
+ * partial sequence between calls, so a file may be fed in buffers of any size.
+ */
+typedef struct utf8_hist {
+    const utf8_alphabet *alphabet;
+    uint32_t state;    // DFA state, 0 between complete code points
+    uint32_t codePoint;
+    uint64_t invalid;  // Malformed or truncated sequences
+    uint64_t *sub;     // UTF8_SUB_HISTS sub-histograms of count + 2 bins, the last one unused
+} utf8_hist;
+
+/**
+ * Builds an alphabet from a UTF-8 string listing its letters, e.g.
+ * UTF8_ALPHABET_POLISH. Returns NULL on invalid UTF-8, repeated letters,
+ * more than UTF8_MAX_LETTERS letters or allocation failure.
+ */
+utf8_alphabet* utf8_alphabet_init(const char *letters);
+
+void utf8_alphabet_deinit(utf8_alphabet *alphabet);
+
+/**
+ * Writes the UTF-8 encoding of a code point to out. Returns its length (1-4).
+ */
+size_t utf8_encode(uint32_t codePoint, char out[4]);
+
+/**
+ * Prepares an empty histogram. Returns false on allocation failure.
+ */
+bool utf8_hist_init(utf8_hist *hist, const utf8_alphabet *alphabet);
+
+void utf8_hist_deinit(utf8_hist *hist);
+
+/**
+ * Decodes data[0..len) and counts every code point, continuing a sequence
+ * split by the previous call. Malformed sequences are counted in `invalid`
+ * and decoding resumes at the next byte that can start a sequence.
+ */
+void utf8_hist_count(utf8_hist *hist, const unsigned char *data, size_t len);
+
+/**
+ * Ends the current stream: a sequence cut off by the end of the data counts as invalid.
+ */
+void utf8_hist_finish(utf8_hist *hist);
+
+/**
+ * Occurrences of letter `index`; index alphabet->count gives all other characters.
+ */
+uint64_t utf8_hist_get(const utf8_hist *hist, size_t index);
+
+/**
+ * Adds the counters of src to dst; both must use the same alphabet.
+ */
+void utf8_hist_add(utf8_hist *dst, const utf8_hist *src);
+
+/**
+ * Stores the counts of the ASCII letters A-Z and a-z in the letter_hist layout,
+ * 0 for those not in the alphabet.
+ */
+void utf8_hist_ascii(const utf8_hist *hist, uint64_t counts[LETTER_COUNT]);
+
+#endif // UTF8_HIST_H
@@ -0,0 +1,120 @@
+#include "ws_deque.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+
+#define ERR(source) (perror(source), fprintf(stderr, "%s:%d\n", __FILE__, __LINE__), exit(EXIT_FAILURE))
+
+// Implementacja wg "Correct and Efficient Work-Stealing for Weak Memory Models"
+// (Lê, Pop, Cohen, Zappa Nardelli, 2013) na wbudowanych __atomic gcc.
+
+static ws_array* array_new(long size, ws_array *retired)
+{
+    ws_array *a = malloc(sizeof(ws_array) + sizeof(void *) * size);
+    if(a == NULL)
+        ERR("malloc");
+    a->size = size;
+    a->retired = retired;
+    return a;
+}
+
+static void* array_get(ws_array *a, long i)
+{
+    return __atomic_load_n(&a->items[i & (a->size - 1)], __ATOMIC_RELAXED);
+}
+
+static void array_put(ws_array *a, long i, void *item)
+{
+    __atomic_store_n(&a->items[i & (a->size - 1)], item, __ATOMIC_RELAXED);
+}
+
+// Stara tablica nie jest zwalniana od razu - złodziej może jeszcze z niej czytać
+static ws_array* array_grow(ws_array *a, long top, long bottom)
+{
+    ws_array *bigger = array_new(a->size * 2, a);
+    for(long i = top; i < bottom; i++)
+        array_put(bigger, i, array_get(a, i));
+    return bigger;
+}
+
+void ws_deque_init(ws_deque *dq)
+{
+    dq->top = 0;
+    dq->bottom = 0;
+    dq->array = array_new(WS_DEQUE_INITIAL_SIZE, NULL);
+}
+
+void ws_deque_deinit(ws_deque *dq)
+{
+    ws_array *a = dq->array;
+    while(a != NULL)
+    {
+        ws_array *next = a->retired;
+        free(a);
+        a = next;
+    }
+    dq->array = NULL;
+}
+
+void ws_deque_push(ws_deque *dq, void *item)
+{
+    long b = __atomic_load_n(&dq->bottom, __ATOMIC_RELAXED);
+    long t = __atomic_load_n(&dq->top, __ATOMIC_ACQUIRE);
+    ws_array *a = __atomic_load_n(&dq->array, __ATOMIC_RELAXED);
+    if(b - t > a->size - 1)
+    {
+        a = array_grow(a, t, b);
+        __atomic_store_n(&dq->array, a, __ATOMIC_RELEASE);
+    }
+    array_put(a, b, item);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    __atomic_store_n(&dq->bottom, b + 1, __ATOMIC_RELAXED);
+}
+
+void* ws_deque_pop(ws_deque *dq)
+{
+    long b = __atomic_load_n(&dq->bottom, __ATOMIC_RELAXED) - 1;
+    ws_array *a = __atomic_load_n(&dq->array, __ATOMIC_RELAXED);
+    __atomic_store_n(&dq->bottom, b, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    long t = __atomic_load_n(&dq->top, __ATOMIC_RELAXED);
+
+    if(t > b)
+    {
+        // deque była pusta
+        __atomic_store_n(&dq->bottom, b + 1, __ATOMIC_RELAXED);
+        return NULL;
+    }
+
+    void *item = array_get(a, b);
+    if(t == b)
+    {
+        // ostatni element - wyścig ze złodziejami
+        if(!__atomic_compare_exchange_n(&dq->top, &t, t + 1, false, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED))
+            item = NULL;
+        __atomic_store_n(&dq->bottom, b + 1, __ATOMIC_RELAXED);
+    }
+    return item;
+}
+
+void* ws_deque_steal(ws_deque *dq)
+{
+    long t = __atomic_load_n(&dq->top, __ATOMIC_ACQUIRE);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    long b = __atomic_load_n(&dq->bottom, __ATOMIC_ACQUIRE);
+    if(t >= b)
+        return NULL;
+
+    ws_array *a = __atomic_load_n(&dq->array, __ATOMIC_ACQUIRE);
+    void *item = array_get(a, t);
+    if(!__atomic_compare_exchange_n(&dq->top, &t, t + 1, false, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED))
+        return NULL; // inny złodziej (lub właściciel) był szybszy
+    return item;
+}
+
+long ws_deque_size(ws_deque *dq)
+{
+    long b = __atomic_load_n(&dq->bottom, __ATOMIC_SEQ_CST);
+    long t = __atomic_load_n(&dq->top, __ATOMIC_SEQ_CST);
+    return b > t ? b - t : 0;
+}
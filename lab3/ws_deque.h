@@ -0,0 +1,57 @@
+#ifndef WS_DEQUE_H
+#define WS_DEQUE_H
+
+#include <stddef.h>
+
+#define WS_CACHE_LINE 64
+#define WS_DEQUE_INITIAL_SIZE 64
+
+typedef struct ws_array {
+    long size;                 // Always a power of two
+    struct ws_array *retired;  // Previous (smaller) array, freed in ws_deque_deinit
+    void *items[];
+} ws_array;
+
+/*
+ * Chase-Lev work-stealing deque. The owner thread pushes and pops at the
+ * bottom, any other thread steals from the top. The array grows on demand.
+ */
+typedef struct ws_deque {
+    long top __attribute__((aligned(WS_CACHE_LINE)));    // Advanced by thieves (CAS)
+    long bottom __attribute__((aligned(WS_CACHE_LINE))); // Written only by the owner
+    ws_array *array;
+} ws_deque;
+
+/**
+ * Initializes an empty deque.
+ */
+void ws_deque_init(ws_deque *dq);
+
+/**
+ * Frees the deque's arrays. Items still in the deque are not freed.
+ */
+void ws_deque_deinit(ws_deque *dq);
+
+/**
+ * Pushes an item at the bottom. Owner thread only.
+ */
+void ws_deque_push(ws_deque *dq, void *item);
+
+/**
+ * Pops the most recently pushed item. Owner thread only.
+ * Returns NULL if the deque is empty.
+ */
+void* ws_deque_pop(ws_deque *dq);
+
+/**
+ * Steals the oldest item. Safe from any thread.
+ * Returns NULL if the deque is empty or the race for the item was lost.
+ */
+void* ws_deque_steal(ws_deque *dq);
+
+/**
+ * Returns the number of items in the deque (a snapshot).
+ */
+long ws_deque_size(ws_deque *dq);
+
+#endif // WS_DEQUE_H
@@ -0,0 +1,124 @@
+#define _GNU_SOURCE
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "counter_array.h"
+
+// Inkrementacje tablicy liczników z practice2 przy rosnącej liczbie wątków:
+// mutex na indeks, atomowe fetch-add i kopie tablicy na wątek (sharded).
+// Indeksy losowane z góry - równomiernie albo z gorącym indeksem 0, który
+// dostaje `hot` procent inkrementacji. Wynik: inkrementacje/s całego procesu.
+// Użycie: ./bench_counters [inkrementacje na wątek] [maks. wątków] [rozmiar tablicy]
+
+#define DEFAULT_OPS 1000000
+#define DEFAULT_MAX_THREADS 64
+#define DEFAULT_SIZE 5 // MAXSIZE z practice2
+#define PATTERN 4096   // indeksy jednego wątku, powtarzane w kółko
+
+#define ERR(source) (perror(source), fprintf(stderr, "%s:%d\n", __FILE__, __LINE__), exit(EXIT_FAILURE))
+
+typedef struct bench_args {
+    pthread_t tid;
+    counter_array *counters;
+    int thread;
+    long ops;
+    const uint32_t *pattern;
+    pthread_barrier_t *start;
+} bench_args_t;
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// `hot` procent trafień w indeks 0, reszta równomiernie po całej tablicy
+static void fill_pattern(uint32_t *pattern, size_t size, int hot, unsigned int seed) {
+    for (int i = 0; i < PATTERN; i++)
+        pattern[i] = rand_r(&seed) % 100 < hot ? 0 : rand_r(&seed) % size;
+}
+
+static void *incrementer(void *voidArgs) {
+    bench_args_t *args = voidArgs;
+    pthread_barrier_wait(args->start);
+    for (long i = 0; i < args->ops; i++)
+        counter_array_increment(args->counters, args->thread, args->pattern[i % PATTERN]);
+    return NULL;
+}
+
+static void run(counter_array_mode mode, int hot, int threads, long ops, size_t size, uint32_t *patterns) {
+    counter_array *counters = counter_array_init(mode, size, threads);
+    if (counters == NULL)
+        ERR("counter_array_init");
+    bench_args_t *args = malloc(sizeof(bench_args_t) * threads);
+    uint64_t *expected = calloc(size, sizeof(uint64_t));
+    uint64_t *total = malloc(sizeof(uint64_t) * size);
+    if (args == NULL || expected == NULL || total == NULL)
+        ERR("malloc");
+    pthread_barrier_t start;
+    pthread_barrier_init(&start, NULL, threads + 1);
+
+    for (int i = 0; i < threads; i++) {
+        args[i] = (bench_args_t){ .counters = counters, .thread = i, .ops = ops,
+                                  .pattern = patterns + (size_t)i * PATTERN, .start = &start };
+        // ops jest wielokrotnością PATTERN, więc każdy indeks wzorca trafia ops / PATTERN razy
+        for (int j = 0; j < PATTERN; j++)
+            expected[args[i].pattern[j]] += ops / PATTERN;
+        if (pthread_create(&args[i].tid, NULL, incrementer, &args[i]))
+            ERR("pthread_create");
+    }
+    double t = now_s();
+    pthread_barrier_wait(&start);
+    for (int i = 0; i < threads; i++) {
+        if (pthread_join(args[i].tid, NULL))
+            ERR("pthread_join");
+    }
+    t = now_s() - t;
+
+    // odczyt zbiorczy po zakończeniu - w sharded suma kopii wszystkich wątków
+    double readStart = now_s();
+    counter_array_snapshot(counters, total);
+    double readNs = (now_s() - readStart) * 1e9;
+    bool ok = memcmp(total, expected, sizeof(uint64_t) * size) == 0;
+
+    printf("%-8s %4d%% %4d %14.0f %9.1f %10.0f %s\n", counter_array_mode_name(mode), hot, threads,
+           ops * threads / t, t * 1e9 / (ops * threads), readNs, ok ? "" : "MISMATCH");
+
+    pthread_barrier_destroy(&start);
+    free(total);
+    free(expected);
+    free(args);
+    counter_array_deinit(counters);
+}
+
+int main(int argc, char **argv) {
+    long ops = argc >= 2 ? atol(argv[1]) : DEFAULT_OPS;
+    int maxThreads = argc >= 3 ? atoi(argv[2]) : DEFAULT_MAX_THREADS;
+    long size = argc >= 4 ? atol(argv[3]) : DEFAULT_SIZE;
+    if (ops <= 0 || maxThreads <= 0 || size <= 0) {
+        printf("Usage: %s [increments per thread] [max threads] [array size]\n", argv[0]);
+        exit(EXIT_FAILURE);
+    }
+    ops = (ops + PATTERN - 1) / PATTERN * PATTERN;
+
+    uint32_t *patterns = malloc(sizeof(uint32_t) * PATTERN * maxThreads);
+    if (patterns == NULL)
+        ERR("malloc");
+    static const int hotPercents[] = { 0, 50, 90 };
+    printf("%ld inkrementacji na wątek, tablica %ld liczników\n", ops, size);
+    printf("%-8s %5s %4s %14s %9s %10s\n", "mode", "hot", "thr", "incr/s", "ns/incr", "read ns");
+    for (size_t h = 0; h < sizeof(hotPercents) / sizeof(hotPercents[0]); h++) {
+        for (int i = 0; i < maxThreads; i++)
+            fill_pattern(patterns + (size_t)i * PATTERN, size, hotPercents[h], 12345 + i);
+        for (int mode = COUNTER_ARRAY_MUTEX; mode <= COUNTER_ARRAY_SHARDED; mode++) {
+            for (int threads = 1; threads <= maxThreads; threads *= 2)
+                run((counter_array_mode)mode, hotPercents[h], threads, ops, size, patterns);
+        }
+    }
+    free(patterns);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,129 @@
+#include "counter_array.h"
+#include <stdlib.h>
+#include <string.h>
+
+static const char *mode_names[] = { "mutex", "atomic", "sharded" };
+
+static void *aligned_calloc(size_t count, size_t size) {
+    void *ptr;
+    if (posix_memalign(&ptr, CA_CACHE_LINE, count * size) != 0)
+        return NULL;
+    memset(ptr, 0, count * size);
+    return ptr;
+}
+
+counter_array *counter_array_init(counter_array_mode mode, size_t size, int threadCount) {
+    if (size == 0 || threadCount < 1)
+        return NULL;
+    counter_array *counters = calloc(1, sizeof(counter_array));
+    if (counters == NULL)
+        return NULL;
+    counters->mode = mode;
+    counters->size = size;
+    counters->threadCount = threadCount;
+
+    switch (mode) {
+        case COUNTER_ARRAY_MUTEX:
+            counters->counts = calloc(size, sizeof(uint64_t));
+            counters->mutexes = malloc(size * sizeof(pthread_mutex_t));
+            if (counters->counts == NULL || counters->mutexes == NULL)
+                break;
+            for (size_t i = 0; i < size; i++) {
+                if (pthread_mutex_init(&counters->mutexes[i], NULL)) {
+                    while (i-- > 0)
+                        pthread_mutex_destroy(&counters->mutexes[i]);
+                    free(counters->mutexes);
+                    counters->mutexes = NULL;
+                    break;
+                }
+            }
+            if (counters->mutexes != NULL)
+                return counters;
+            break;
+        case COUNTER_ARRAY_ATOMIC:
+            counters->padded = aligned_calloc(size, sizeof(counter_array_padded));
+            if (counters->padded != NULL)
+                return counters;
+            break;
+        case COUNTER_ARRAY_SHARDED:
+            // każdy wątek ma własną kopię tablicy od początku linii cache - inkrementacja nie dotyka cudzych linii
+            counters->stride = (size * sizeof(uint64_t) + CA_CACHE_LINE - 1) / CA_CACHE_LINE * (CA_CACHE_LINE / sizeof(uint64_t));
+            counters->shards = aligned_calloc((size_t)threadCount * counters->stride, sizeof(uint64_t));
+            if (counters->shards != NULL)
+                return counters;
+            break;
+    }
+    free(counters->counts);
+    free(counters->mutexes);
+    free(counters);
+    return NULL;
+}
+
+void counter_array_deinit(counter_array *counters) {
+    if (counters->mutexes != NULL) {
+        for (size_t i = 0; i < counters->size; i++)
+            pthread_mutex_destroy(&counters->mutexes[i]);
+    }
+    free(counters->mutexes);
+    free(counters->counts);
+    free(counters->padded);
+    free(counters->shards);
+    free(counters);
+}
+
+void counter_array_increment(counter_array *counters, int thread, size_t index) {
+    switch (counters->mode) {
+        case COUNTER_ARRAY_MUTEX:
+            pthread_mutex_lock(&counters->mutexes[index]);
+            counters->counts[index]++;
+            pthread_mutex_unlock(&counters->mutexes[index]);
+            break;
+        case COUNTER_ARRAY_ATOMIC:
+            __atomic_fetch_add(&counters->padded[index].value, 1, __ATOMIC_RELAXED);
+            break;
+        case COUNTER_ARRAY_SHARDED: {
+            // jedyny piszący do swojej kopii: zwykły odczyt i zapis, atomowe tylko po to, by czytelnik nie zobaczył połowy słowa
+            uint64_t *slot = &counters->shards[(size_t)thread * counters->stride + index];
+            __atomic_store_n(slot, __atomic_load_n(slot, __ATOMIC_RELAXED) + 1, __ATOMIC_RELAXED);
+            break;
+        }
+    }
+}
+
+uint64_t counter_array_get(counter_array *counters, size_t index) {
+    uint64_t value = 0;
+    switch (counters->mode) {
+        case COUNTER_ARRAY_MUTEX:
+            pthread_mutex_lock(&counters->mutexes[index]);
+            value = counters->counts[index];
+            pthread_mutex_unlock(&counters->mutexes[index]);
+            break;
+        case COUNTER_ARRAY_ATOMIC:
+            value = __atomic_load_n(&counters->padded[index].value, __ATOMIC_RELAXED);
+            break;
+        case COUNTER_ARRAY_SHARDED:
+            for (int t = 0; t < counters->threadCount; t++)
+                value += __atomic_load_n(&counters->shards[(size_t)t * counters->stride + index], __ATOMIC_RELAXED);
+            break;
+    }
+    return value;
+}
+
+void counter_array_snapshot(counter_array *counters, uint64_t *out) {
+    for (size_t i = 0; i < counters->size; i++)
+        out[i] = counter_array_get(counters, i);
+}
+
+bool counter_array_parse_mode(const char *name, counter_array_mode *mode) {
+    for (size_t i = 0; i < sizeof(mode_names) / sizeof(mode_names[0]); i++) {
+        if (strcmp(name, mode_names[i]) == 0) {
+            *mode = (counter_array_mode)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char *counter_array_mode_name(counter_array_mode mode) {
+    return mode_names[mode];
+}
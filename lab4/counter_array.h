@@ -0,0 +1,72 @@
+#ifndef COUNTER_ARRAY_H
+#define COUNTER_ARRAY_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define CA_CACHE_LINE 64
+
+typedef enum counter_array_mode {
+    COUNTER_ARRAY_MUTEX,  // One mutex per index next to a plain array, as in practice2
+    COUNTER_ARRAY_ATOMIC, // Relaxed fetch-add on counters padded to a cache line each
+    COUNTER_ARRAY_SHARDED // Per-thread copies of the array, summed only when read
+} counter_array_mode;
+
+typedef struct counter_array_padded {
+    uint64_t value;
+} __attribute__((aligned(CA_CACHE_LINE))) counter_array_padded;
+
+typedef struct counter_array {
+    counter_array_mode mode;
+    size_t size;
+    int threadCount;
+    uint64_t *counts;              // COUNTER_ARRAY_MUTEX
+    pthread_mutex_t *mutexes;      // COUNTER_ARRAY_MUTEX, one per index
+    counter_array_padded *padded;  // COUNTER_ARRAY_ATOMIC
+    uint64_t *shards;              // COUNTER_ARRAY_SHARDED, shard t at shards + t * stride
+    size_t stride;                 // size rounded up to whole cache lines, so no two threads share one
+} counter_array;
+
+/**
+ * Creates `size` zeroed counters updated by `threadCount` threads numbered
+ * 0..threadCount-1. Returns a pointer to the structure, or NULL on failure.
+ */
+counter_array *counter_array_init(counter_array_mode mode, size_t size, int threadCount);
+
+/**
+ * Destroys the structure and frees all associated resources.
+ */
+void counter_array_deinit(counter_array *counters);
+
+/**
+ * Adds 1 to counter `index`. `thread` is the caller's number; in
+ * COUNTER_ARRAY_SHARDED two threads must never pass the same number, since
+ * each shard has a single writer and is updated without atomic read-modify-write.
+ */
+void counter_array_increment(counter_array *counters, int thread, size_t index);
+
+/**
+ * Current value of counter `index`. In COUNTER_ARRAY_SHARDED this sums the
+ * shards of all threads, so it costs threadCount loads instead of one.
+ */
+uint64_t counter_array_get(counter_array *counters, size_t index);
+
+/**
+ * Fills out[0..size) with all counters. Increments running at the same time
+ * may or may not be included; each counter is read without tearing.
+ */
+void counter_array_snapshot(counter_array *counters, uint64_t *out);
+
+/**
+ * Parses "mutex", "atomic" or "sharded". Returns false on unknown names.
+ */
+bool counter_array_parse_mode(const char *name, counter_array_mode *mode);
+
+/**
+ * Returns the name of the mode as accepted by counter_array_parse_mode.
+ */
+const char *counter_array_mode_name(counter_array_mode mode);
+
+#endif // COUNTER_ARRAY_H
@@ -5,7 +5,9 @@
 #include <stdlib.h>
 #include <pthread.h>
 #include <signal.h>
+#include <string.h>
 #include <time.h>
+#include "counter_array.h"
 
 #define ERR(source) (perror(source), \
 fprintf(stderr, "%s:%d\n", __FILE__, __LINE__), exit(EXIT_FAILURE))
@@ -20,8 +22,8 @@ typedef struct argsSignalHandler {
 
 typedef struct workerThread {
     pthread_t tid;
-    pthread_mutex_t *mxArray; // tablica mutexów
-    int *array;              // tablica liczników
+    counter_array *counters; // tablica liczników (mutex na indeks, atomowe albo kopie na wątek)
+    int thread;              // numer wątku, wybiera jego kopię w trybie sharded
     int size;                // rozmiar tablicy
 } worker_t;
 
@@ -29,6 +31,12 @@ void *signal_handling(void *);
 void *worker(void *);
 
 int main(int argc, char **argv) {
+    counter_array_mode mode = COUNTER_ARRAY_SHARDED;
+    if (argc >= 2 && !counter_array_parse_mode(argv[1], &mode)) {
+        fprintf(stderr, "Usage: %s [mutex|atomic|sharded]\n", argv[0]);
+        exit(EXIT_FAILURE);
+    }
+
     // Maskowanie sygnałów w wątku głównym
     sigset_t oldMask, newMask;
     sigemptyset(&newMask);
@@ -44,20 +52,15 @@ int main(int argc, char **argv) {
         ERR("pthread_create");
 
     // Etap 2: Inicjalizacja zasobów
-    pthread_mutex_t mxArray[MAXSIZE];
-    int array[MAXSIZE] = {0}; // Tablica liczników
-
-    // Inicjalizacja mutexów
-    for (int i = 0; i < MAXSIZE; i++) {
-        if (pthread_mutex_init(&mxArray[i], NULL))
-            ERR("pthread_mutex_init");
-    }
+    counter_array *counters = counter_array_init(mode, MAXSIZE, THREAD_COUNT);
+    if (counters == NULL)
+        ERR("counter_array_init");
 
     // Tworzenie wątków workerów
     worker_t workers[THREAD_COUNT];
     for (int i = 0; i < THREAD_COUNT; i++) {
-        workers[i].mxArray = mxArray;
-        workers[i].array = array;
+        workers[i].counters = counters;
+        workers[i].thread = i;
         workers[i].size = MAXSIZE;
         if (pthread_create(&workers[i].tid, NULL, worker, &workers[i]))
             ERR("pthread_create");
@@ -69,11 +72,14 @@ int main(int argc, char **argv) {
             ERR("pthread_join");
     }
 
+    // Odczyt zbiorczy - w trybie sharded suma kopii wszystkich wątków
+    printf("Counters (%s):", counter_array_mode_name(mode));
+    for (int i = 0; i < MAXSIZE; i++)
+        printf(" %lu", (unsigned long)counter_array_get(counters, i));
+    printf("\n");
+
     // Czyszczenie zasobów
-    for (int i = 0; i < MAXSIZE; i++) {
-        if (pthread_mutex_destroy(&mxArray[i]))
-            ERR("pthread_mutex_destroy");
-    }
+    counter_array_deinit(counters);
 
     if (pthread_join(args.tid, NULL))
         ERR("Can't join with 'signal handling' thread");
@@ -107,16 +113,17 @@ void *signal_handling(void *voidArgs) {
 
 void *worker(void *voidArgs) {
     worker_t *args = (worker_t *)voidArgs;
-    srand(pthread_self());
+    unsigned int seed = pthread_self();
+    int incremented[MAXSIZE] = {0};
     for (int i = 0; i < 100; i++) { // Każdy wątek wykonuje 100 operacji
-        int index = rand() % args->size; // Losowy indeks w tablicy
-        if (pthread_mutex_lock(&args->mxArray[index]))
-            ERR("pthread_mutex_lock");
-        args->array[index]++;
-        printf("Thread %lu incremented index %d, new value: %d\n",
-               pthread_self(), index, args->array[index]);
-        if (pthread_mutex_unlock(&args->mxArray[index]))
-            ERR("pthread_mutex_unlock");
+        int index = rand_r(&seed) % args->size; // Losowy indeks w tablicy
+        counter_array_increment(args->counters, args->thread, index);
+        incremented[index]++;
     }
+    // Wypisywanie poza sekcją krytyczną, raz na wątek zamiast przy każdej inkrementacji
+    printf("Thread %d incremented:", args->thread);
+    for (int i = 0; i < args->size; i++)
+        printf(" %d", incremented[i]);
+    printf("\n");
     return NULL;
 }
\ No newline at end of file